@@ -6,7 +6,9 @@
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
+#include "threads/softirq.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -71,7 +73,8 @@ struct channel {
 	struct lock lock;           /* Must acquire to access the controller. */
 	bool expecting_interrupt;   /* True if an interrupt is expected, false if
 								   any interrupt would be spurious. */
-	struct semaphore completion_wait;   /* Up'd by interrupt handler. */
+	bool completed;             /* Interrupt seen, waiter not yet woken. */
+	struct semaphore completion_wait;   /* Up'd by the block softirq. */
 
 	struct disk devices[2];     /* The devices on this channel. */
 };
@@ -95,12 +98,14 @@ static void select_device (const struct disk *);
 static void select_device_wait (const struct disk *);
 
 static void interrupt_handler (struct intr_frame *);
+static softirq_func block_softirq;
 
 /* Initialize the disk subsystem and detect disks. */
 void
 disk_init (void) {
 	size_t chan_no;
 
+	softirq_register (SOFTIRQ_BLOCK, block_softirq, NULL);
 	for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++) {
 		struct channel *c = &channels[chan_no];
 		int dev_no;
@@ -119,8 +124,9 @@ disk_init (void) {
 			default:
 				NOT_REACHED ();
 		}
-		lock_init (&c->lock);
+		lock_init_named (&c->lock, c->name);
 		c->expecting_interrupt = false;
+		c->completed = false;
 		sema_init (&c->completion_wait, 0);
 
 		/* Initialize devices. */
@@ -214,6 +220,7 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
 	ASSERT (d != NULL);
 	ASSERT (buffer != NULL);
 
+	TRACE (TRACE_DISK_READ, sec_no);
 	c = d->channel;
 	lock_acquire (&c->lock);
 	select_sector (d, sec_no);
@@ -238,6 +245,7 @@ disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
 	ASSERT (d != NULL);
 	ASSERT (buffer != NULL);
 
+	TRACE (TRACE_DISK_WRITE, sec_no);
 	c = d->channel;
 	lock_acquire (&c->lock);
 	select_sector (d, sec_no);
@@ -511,7 +519,9 @@ select_device_wait (const struct disk *d) {
 	wait_until_idle (d);
 }
 
-/* ATA interrupt handler. */
+/* ATA interrupt handler.
+   Only acknowledges the interrupt; the waiter is woken by
+   block_softirq() once interrupts are back on. */
 static void
 interrupt_handler (struct intr_frame *f) {
 	struct channel *c;
@@ -520,7 +530,8 @@ interrupt_handler (struct intr_frame *f) {
 		if (f->vec_no == c->irq) {
 			if (c->expecting_interrupt) {
 				inb (reg_status (c));               /* Acknowledge interrupt. */
-				sema_up (&c->completion_wait);      /* Wake up waiter. */
+				c->completed = true;
+				softirq_raise (SOFTIRQ_BLOCK);
 			} else
 				printf ("%s: unexpected interrupt\n", c->name);
 			return;
@@ -529,6 +540,24 @@ interrupt_handler (struct intr_frame *f) {
 	NOT_REACHED ();
 }
 
+/* Block softirq.  Wakes the thread waiting on each channel whose
+   interrupt has arrived. */
+static void
+block_softirq (void *aux UNUSED) {
+	struct channel *c;
+
+	for (c = channels; c < channels + CHANNEL_CNT; c++) {
+		enum intr_level old_level = intr_disable ();
+		bool completed = c->completed;
+
+		c->completed = false;
+		intr_set_level (old_level);
+
+		if (completed)
+			sema_up (&c->completion_wait);      /* Wake up waiter. */
+	}
+}
+
 static void
 inspect_read_cnt (struct intr_frame *f) {
 	struct disk * d = disk_get (f->R.rdx, f->R.rcx);
@@ -2,14 +2,22 @@
 #include <debug.h>
 #include "devices/intq.h"
 #include "devices/serial.h"
+#include "threads/synch.h"
 
 /* Stores keys from the keyboard and serial port. */
 static struct intq buffer;
 
+/* Number of keys in BUFFER.  Readers wait here rather than in
+   BUFFER itself, so that sema_kill() can interrupt the wait. */
+static struct semaphore keys;
+
+static uint8_t take_key (void);
+
 /* Initializes the input buffer. */
 void
 input_init (void) {
 	intq_init (&buffer);
+	sema_init (&keys, 0);
 }
 
 /* Adds a key to the input buffer.
@@ -20,6 +28,7 @@ input_putc (uint8_t key) {
 	ASSERT (!intq_full (&buffer));
 
 	intq_putc (&buffer, key);
+	sema_up (&keys);
 	serial_notify ();
 }
 
@@ -27,15 +36,20 @@ input_putc (uint8_t key) {
    If the buffer is empty, waits for a key to be pressed. */
 uint8_t
 input_getc (void) {
-	enum intr_level old_level;
-	uint8_t key;
-
-	old_level = intr_disable ();
-	key = intq_getc (&buffer);
-	serial_notify ();
-	intr_set_level (old_level);
+	sema_down (&keys);
+	return take_key ();
+}
 
-	return key;
+/* Like input_getc(), but gives up waiting once sema_kill() has
+   been called on the current thread.  Stores the key in *KEY and
+   returns true, or returns false if the thread was killed before
+   a key arrived. */
+bool
+input_getc_killable (uint8_t *key) {
+	if (!sema_down_killable (&keys))
+		return false;
+	*key = take_key ();
+	return true;
 }
 
 /* Returns true if the input buffer is full,
@@ -46,3 +60,27 @@ input_full (void) {
 	ASSERT (intr_get_level () == INTR_OFF);
 	return intq_full (&buffer);
 }
+
+/* Returns true if the input buffer is empty,
+   false otherwise.
+   Interrupts must be off. */
+bool
+input_empty (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	return intq_empty (&buffer);
+}
+
+/* Removes a key from the input buffer, which the caller has
+   made sure is not empty by taking it from KEYS. */
+static uint8_t
+take_key (void) {
+	enum intr_level old_level;
+	uint8_t key;
+
+	old_level = intr_disable ();
+	key = intq_getc (&buffer);
+	serial_notify ();
+	intr_set_level (old_level);
+
+	return key;
+}
@@ -0,0 +1,203 @@
+#include "devices/lapic.h"
+#include <debug.h>
+#include "devices/timer.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/pte.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* Local APIC.  See [IA32-v3a] chapter 10 "Advanced Programmable
+   Interrupt Controller (APIC)".
+
+   Every CPU has its own local APIC at the same physical address.
+   We use it to send interprocessor interrupts and, on the
+   application processors, as the timer.  The 8254 and the other
+   devices stay on the 8259A PICs, which reach only the bootstrap
+   processor, through its LINT0 ("virtual wire" mode), so no I/O
+   APIC is programmed. */
+
+/* Register offsets, in bytes. */
+#define ID 0x020                /* Local APIC ID. */
+#define TPR 0x080               /* Task priority. */
+#define EOI 0x0b0               /* End of interrupt. */
+#define SVR 0x0f0               /* Spurious interrupt vector. */
+#define ICRLO 0x300             /* Interrupt command, bits 0...31. */
+#define ICRHI 0x310             /* Interrupt command, bits 32...63. */
+#define TIMER 0x320             /* LVT timer. */
+#define LINT0 0x350             /* LVT LINT0. */
+#define LINT1 0x360             /* LVT LINT1. */
+#define TICR 0x380              /* Timer initial count. */
+#define TCCR 0x390              /* Timer current count. */
+#define TDCR 0x3e0              /* Timer divide configuration. */
+
+/* Register bits. */
+#define SVR_ENABLE 0x100        /* APIC software enable. */
+#define LVT_MASKED 0x10000      /* Interrupt masked. */
+#define LVT_PERIODIC 0x20000    /* Timer: periodic, not one-shot. */
+#define LVT_NMI 0x400           /* Delivery mode NMI. */
+#define LVT_EXTINT 0x700        /* Delivery mode ExtINT. */
+#define ICR_INIT 0x500          /* Delivery mode INIT. */
+#define ICR_STARTUP 0x600       /* Delivery mode Start-up. */
+#define ICR_PENDING 0x1000      /* Delivery status: send pending. */
+#define ICR_ASSERT 0x4000       /* Level: assert. */
+#define ICR_LEVEL 0x8000        /* Trigger mode: level. */
+#define TDCR_16 0x3             /* Divide the bus clock by 16. */
+
+/* Number of milliseconds lapic_init() measures the timer over. */
+#define CALIBRATE_MS 10
+
+/* Local APIC registers, mapped uncached. */
+static volatile uint32_t *lapic;
+
+/* Timer count per timer tick, dividing by 16. */
+static uint32_t timer_count;
+
+static intr_handler_func timer_interrupt;
+static intr_handler_func spurious_interrupt;
+
+/* Returns the local APIC register at offset REG. */
+static uint32_t
+lapic_read (int reg) {
+	return lapic[reg / 4];
+}
+
+/* Writes VALUE to the local APIC register at offset REG. */
+static void
+lapic_write (int reg, uint32_t value) {
+	lapic[reg / 4] = value;
+	(void) lapic[ID / 4];   /* Wait for the write to finish. */
+}
+
+/* Sends the interprocessor interrupt described by LO, the low
+   half of the interrupt command register, to the CPU whose local
+   APIC ID is ID. */
+static void
+send_icr (uint8_t id, uint32_t lo) {
+	enum intr_level old_level = intr_disable ();
+
+	while (lapic_read (ICRLO) & ICR_PENDING)
+		asm volatile ("pause");
+	lapic_write (ICRHI, (uint32_t) id << 24);
+	lapic_write (ICRLO, lo);
+	intr_set_level (old_level);
+}
+
+/* Maps the local APICs at physical address PA, enables the
+   bootstrap processor's, and measures the timer frequency
+   against the TSC for lapic_init_ap().  The bootstrap processor
+   keeps counting ticks with the 8254. */
+void
+lapic_init (uint64_t pa) {
+	uint64_t *pte;
+	uint64_t start, cycles;
+	bool enabled;
+
+	ASSERT (timer_tsc_hz () != 0);
+
+	/* 물리 메모리 끝보다 위에 있어서 paging_init()이 매핑하지 않았다.
+	   커널 영역의 page table은 모든 유저 pml4가 공유한다 */
+	pte = pml4e_walk (base_pml4, (uint64_t) ptov (pa), 1);
+	if (pte == NULL)
+		PANIC ("lapic: out of memory");
+	*pte = pa | PTE_P | PTE_W | PTE_PWT | PTE_PCD;
+	lapic = ptov (pa);
+
+	intr_register_ext (LAPIC_TIMER_VEC, timer_interrupt, "LAPIC Timer");
+	intr_register_int (LAPIC_SPURIOUS_VEC, 0, INTR_OFF, spurious_interrupt,
+			"LAPIC Spurious Interrupt");
+
+	/* BIOS가 꺼두었다면 켠 뒤에 8259A를 LINT0에 다시 연결한다.
+	   꺼져 있는 동안에는 LVT의 mask bit를 지울 수 없다 */
+	enabled = lapic_read (SVR) & SVR_ENABLE;
+	lapic_write (SVR, SVR_ENABLE | LAPIC_SPURIOUS_VEC);
+	if (!enabled) {
+		lapic_write (LINT0, LVT_EXTINT);
+		lapic_write (LINT1, LVT_NMI);
+	}
+	lapic_write (TPR, 0);
+
+	/* Count down from the largest value for CALIBRATE_MS. */
+	lapic_write (TDCR, TDCR_16);
+	lapic_write (TIMER, LVT_MASKED | LAPIC_TIMER_VEC);
+	lapic_write (TICR, UINT32_MAX);
+	cycles = timer_tsc_hz () * CALIBRATE_MS / 1000;
+	start = rdtsc ();
+	while (rdtsc () - start < cycles)
+		asm volatile ("pause");
+	timer_count = (uint64_t) (UINT32_MAX - lapic_read (TCCR))
+		* 1000 / CALIBRATE_MS / TIMER_FREQ;
+	lapic_write (TICR, 0);
+}
+
+/* Enables the local APIC of the application processor that calls
+   it and starts its timer at TIMER_FREQ.  PIC interrupts stay
+   with the bootstrap processor. */
+void
+lapic_init_ap (void) {
+	lapic_write (SVR, SVR_ENABLE | LAPIC_SPURIOUS_VEC);
+	lapic_write (LINT0, LVT_MASKED);
+	lapic_write (LINT1, LVT_NMI);
+	lapic_write (TPR, 0);
+
+	lapic_write (TDCR, TDCR_16);
+	lapic_write (TIMER, LVT_PERIODIC | LAPIC_TIMER_VEC);
+	lapic_write (TICR, timer_count);
+}
+
+/* Returns the local APIC ID of the CPU that calls it. */
+uint8_t
+lapic_id (void) {
+	return lapic_read (ID) >> 24;
+}
+
+/* Acknowledges the interrupt being handled on this CPU. */
+void
+lapic_eoi (void) {
+	lapic_write (EOI, 0);
+}
+
+/* Sends interrupt VEC to the CPU whose local APIC ID is ID. */
+void
+lapic_send_ipi (uint8_t id, uint8_t vec) {
+	send_icr (id, vec);
+}
+
+/* Starts the application processor whose local APIC ID is ID in
+   real mode at physical address ENTRY, which must be page
+   aligned and below 1 MB.  Uses the INIT-SIPI-SIPI sequence of
+   [IA32-v3a] 8.4.4.1 "Typical BSP Initialization Sequence".
+   Sleeps, so interrupts must be on. */
+void
+lapic_start_ap (uint8_t id, uint64_t entry) {
+	ASSERT (entry % PGSIZE == 0 && entry < 0x100000);
+	ASSERT (intr_get_level () == INTR_ON);
+
+	send_icr (id, ICR_INIT | ICR_LEVEL | ICR_ASSERT);
+	timer_msleep (10);
+	send_icr (id, ICR_INIT | ICR_LEVEL);
+
+	/* 첫 번째 SIPI로 시작하지 않는 CPU를 위해 한 번 더 보낸다.
+	   이미 시작한 CPU는 두 번째 SIPI를 무시한다 */
+	for (int i = 0; i < 2; i++) {
+		send_icr (id, ICR_STARTUP | entry >> 12);
+		timer_usleep (200);
+	}
+}
+
+/* Timer interrupt of an application processor.  Only the
+   bootstrap processor's 8254 advances the tick count; this just
+   runs the scheduler's per-tick work for the local CPU. */
+static void
+timer_interrupt (struct intr_frame *args UNUSED) {
+	thread_tick ();
+}
+
+/* The local APIC raises its spurious vector when an interrupt
+   goes away before the CPU accepts it.  It must not be
+   acknowledged. */
+static void
+spurious_interrupt (struct intr_frame *args UNUSED) {
+}
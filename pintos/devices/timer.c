@@ -3,10 +3,13 @@
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/softirq.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -17,17 +20,74 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
+/* Input clock of the 8254, in Hz. */
+#define PIT_HZ 1193180
+
+/* Shortest one-shot count we program, so that an already passed
+   deadline still gets an interrupt instead of none. */
+#define PIT_MIN_COUNT 4
+
+/* Number of ticks timer_calibrate() measures the TSC over. */
+#define CALIBRATE_TICKS 10
+
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
-/* Number of loops per timer tick.
-   Initialized by timer_calibrate(). */
-static unsigned loops_per_tick;
+/* TSC clocksource.
+   Until timer_calibrate() has measured the TSC, the 8254 runs in
+   periodic mode and interrupts once per tick.  After that it is
+   used as a one-shot timer (mode 0), reprogrammed on each
+   interrupt for the earlier of the next tick and the first
+   high-resolution sleeper, and the TSC decides which of them are
+   due.  Ticks missed while interrupts were off are caught up. */
+static uint64_t tsc_hz;         /* TSC cycles per second, 0 before calibration. */
+static uint64_t tsc_per_tick;   /* TSC cycles per timer tick. */
+static uint64_t next_tick_tsc;  /* TSC value at which the next tick is due. */
+
+/* Tickless idle.
+   While the idle thread halts, the one-shot is programmed for the
+   next kernel timer or sleeper instead of the next tick, and the
+   skipped ticks are accounted when the CPU wakes up. */
+static bool tick_stopped;
+
+/* Threads blocked in a sub-tick sleep, by earliest deadline. */
+static struct list hr_sleepers;
+
+/* A thread in a high-resolution sleep.  Lives on its stack. */
+struct hr_sleeper {
+	uint64_t deadline;          /* TSC value to wake at. */
+	struct thread *thread;      /* Sleeping thread. */
+	struct list_elem elem;      /* Element in hr_sleepers. */
+};
+
+/* Hierarchical timing wheel for kernel timers.
+   Level N has WHEEL_SIZE slots and each slot covers WHEEL_SIZE^N
+   ticks, so level 0 holds the timers that expire within the next
+   WHEEL_SIZE ticks and each higher level holds timers further in
+   the future.  Arming or canceling a timer is a single list
+   operation.  Whenever the lower level wraps around, the matching
+   slot of the next level is "cascaded" down, so each timer moves
+   at most WHEEL_LEVELS times before it expires. */
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 4
+#define WHEEL_RANGE (1LL << (WHEEL_BITS * WHEEL_LEVELS))
+static struct list wheel[WHEEL_LEVELS][WHEEL_SIZE];
+
+/* Next tick to be processed by the timer wheel. */
+static int64_t wheel_tick;
 
 static intr_handler_func timer_interrupt;
-static bool too_many_loops (unsigned loops);
-static void busy_wait (int64_t loops);
+static softirq_func timer_softirq;
+static void timer_tick (void);
+static void timer_program (void);
+static void hr_sleep (int64_t ns);
+static bool hr_wake (uint64_t now);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void wheel_insert (struct timer_event *);
+static bool wheel_advance (void);
+static int64_t wheel_next_deadline (void);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
@@ -36,38 +96,67 @@ void
 timer_init (void) {
 	/* 8254 input frequency divided by TIMER_FREQ, rounded to
 	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+	uint16_t count = (PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ;
 
 	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
 	outb (0x40, count & 0xff);
 	outb (0x40, count >> 8);
 
+	for (int level = 0; level < WHEEL_LEVELS; level++)
+		for (int slot = 0; slot < WHEEL_SIZE; slot++)
+			list_init (&wheel[level][slot]);
+	list_init (&hr_sleepers);
+
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
+	softirq_register (SOFTIRQ_TIMER, timer_softirq, NULL);
 }
 
-/* Calibrates loops_per_tick, used to implement brief delays. */
+/* Measures the TSC frequency against the 8254 and switches the
+   8254 to one-shot mode for high-resolution sleeps. */
 void
 timer_calibrate (void) {
-	unsigned high_bit, test_bit;
+	enum intr_level old_level;
+	uint64_t start_tsc;
+	int64_t start;
 
 	ASSERT (intr_get_level () == INTR_ON);
 	printf ("Calibrating timer...  ");
 
-	/* Approximate loops_per_tick as the largest power-of-two
-	   still less than one timer tick. */
-	loops_per_tick = 1u << 10;
-	while (!too_many_loops (loops_per_tick << 1)) {
-		loops_per_tick <<= 1;
-		ASSERT (loops_per_tick != 0);
-	}
+	/* Count TSC cycles over CALIBRATE_TICKS ticks, starting right
+	   at a tick boundary. */
+	start = ticks;
+	while (ticks == start)
+		barrier ();
+	start_tsc = rdtsc ();
+	start = ticks;
+	while (ticks - start < CALIBRATE_TICKS)
+		barrier ();
+
+	old_level = intr_disable ();
+	tsc_hz = (rdtsc () - start_tsc) * TIMER_FREQ / CALIBRATE_TICKS;
+	tsc_per_tick = tsc_hz / TIMER_FREQ;
+	next_tick_tsc = rdtsc () + tsc_per_tick;
+	timer_program ();
+	intr_set_level (old_level);
 
-	/* Refine the next 8 bits of loops_per_tick. */
-	high_bit = loops_per_tick;
-	for (test_bit = high_bit >> 1; test_bit != high_bit >> 10; test_bit >>= 1)
-		if (!too_many_loops (high_bit | test_bit))
-			loops_per_tick |= test_bit;
+	printf ("%'"PRIu64" TSC cycles/s.\n", tsc_hz);
+}
+
+/* Returns the calibrated TSC frequency in Hz, or 0 if
+   timer_calibrate() has not run yet. */
+uint64_t
+timer_tsc_hz (void) {
+	return tsc_hz;
+}
 
-	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+/* Converts CYCLES of the TSC to nanoseconds. */
+uint64_t
+timer_tsc_to_ns (uint64_t cycles) {
+	if (tsc_hz == 0)
+		return 0;
+	/* 곱셈이 넘치지 않도록 초 단위와 나머지를 나눠 계산 */
+	return cycles / tsc_hz * 1000000000ULL
+		+ cycles % tsc_hz * 1000000000ULL / tsc_hz;
 }
 
 /* Returns the number of timer ticks since the OS booted. 
@@ -96,6 +185,8 @@ timer_sleep (int64_t ticks) {
 	int64_t start = timer_ticks ();
 
 	ASSERT (intr_get_level () == INTR_ON);
+	if (ticks <= 0)
+		return;
 	thread_sleep (start + ticks);	// 계속 반복해서 busy waiting 하기 떄문에 변경
 }
 
@@ -117,49 +208,321 @@ timer_nsleep (int64_t ns) {
 	real_time_sleep (ns, 1000 * 1000 * 1000);
 }
 
+/* Arms timer EV so that FUNC(AUX) is called from the timer
+   softirq once the tick count reaches DEADLINE.  FUNC runs with
+   interrupts off and must not sleep.  A deadline
+   that has already passed fires on the next tick.  EV must not
+   already be armed. */
+void
+timer_arm (struct timer_event *ev, int64_t deadline,
+		timer_func *func, void *aux) {
+	enum intr_level old_level;
+
+	ASSERT (ev != NULL);
+	ASSERT (func != NULL);
+
+	old_level = intr_disable ();
+	ASSERT (!ev->armed);
+	ev->deadline = deadline;
+	ev->func = func;
+	ev->aux = aux;
+	ev->armed = true;
+	wheel_insert (ev);
+	intr_set_level (old_level);
+}
+
+/* Cancels timer EV.  Returns true if EV was armed and has been
+   removed before expiring, false if it was not armed. */
+bool
+timer_cancel (struct timer_event *ev) {
+	enum intr_level old_level;
+	bool was_armed;
+
+	ASSERT (ev != NULL);
+
+	old_level = intr_disable ();
+	was_armed = ev->armed;
+	if (was_armed) {
+		list_remove (&ev->elem);
+		ev->armed = false;
+	}
+	intr_set_level (old_level);
+
+	return was_armed;
+}
+
+/* Stops the periodic tick until timer_idle_exit().  Called by
+   the idle thread, with interrupts off, right before it halts.
+   Timer interrupts still come for kernel timers and sleepers,
+   and catch up the ticks that passed in between.  The tick keeps
+   running while any other CPU runs a thread, because that thread
+   may read timer_ticks(). */
+void
+timer_idle_enter (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (tsc_hz == 0 || !cpu_all_idle ())
+		return;
+	tick_stopped = true;
+	timer_program ();
+}
+
+/* Restarts the periodic tick when a CPU switches from its idle
+   thread to another thread.  Any tick that is already due fires
+   at once, so the tick count and the CPU statistics are brought
+   up to date by the interrupt handler. */
+void
+timer_idle_exit (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!tick_stopped)
+		return;
+	tick_stopped = false;
+	timer_program ();
+}
+
 /* Prints timer statistics. */
 void
 timer_print_stats (void) {
 	printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
 }
 
-/* Timer interrupt handler. */
+/* Timer interrupt handler.
+   Kernel timers are run afterward by the timer softirq. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED) {
+	if (tsc_per_tick == 0)
+		timer_tick ();
+	else {
+		uint64_t now = rdtsc ();
+
+		while ((int64_t) (now - next_tick_tsc) >= 0) {
+			next_tick_tsc += tsc_per_tick;
+			timer_tick ();
+		}
+		if (hr_wake (now))
+			thread_maybe_yield ();	// 깨어난 스레드가 더 높은 priority일 수 있으니까 체크
+		timer_program ();
+	}
+}
+
+/* Accounts for one timer tick. */
+static void
+timer_tick (void) {
 	ticks++;
 	thread_tick ();
-	thread_wakeup (ticks);
+	softirq_raise (SOFTIRQ_TIMER);
+}
+
+/* Timer softirq.  Runs the kernel timers that expired up to the
+   current tick. */
+static void
+timer_softirq (void *aux UNUSED) {
+	if (wheel_advance ())
+		thread_maybe_yield ();	// 깨어난 스레드가 더 높은 priority일 수 있으니까 체크
+}
+
+/* Programs the 8254 to interrupt once, at the earlier of the next
+   tick and the first high-resolution sleeper's deadline. */
+static void
+timer_program (void) {
+	uint64_t deadline = next_tick_tsc;
+	int64_t delta;
+	uint64_t count;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	/* 틱이 멈춰 있으면 다음 kernel timer가 만료되는 틱까지 건너뛴다.
+		1초 넘게 떨어져 있어도 어차피 한 번에 0xffff 카운트까지만 잴 수 있다 */
+	if (tick_stopped) {
+		int64_t skip = wheel_next_deadline () - ticks - 1;
+
+		if (skip > TIMER_FREQ)
+			skip = TIMER_FREQ;
+		if (skip > 0)
+			deadline += skip * tsc_per_tick;
+	}
+
+	if (!list_empty (&hr_sleepers)) {
+		struct hr_sleeper *s = list_entry (list_front (&hr_sleepers),
+				struct hr_sleeper, elem);
+		if ((int64_t) (s->deadline - deadline) < 0)
+			deadline = s->deadline;
+	}
+
+	/* 마감 시각보다 일찍 울리지 않도록 올림 */
+	delta = deadline - rdtsc ();
+	count = delta <= 0 ? 0 : (delta * PIT_HZ + tsc_hz - 1) / tsc_hz;
+	if (count < PIT_MIN_COUNT)
+		count = PIT_MIN_COUNT;
+	if (count > 0xffff)
+		count = 0xffff;
+
+	outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
 }
 
-/* Returns true if LOOPS iterations waits for more than one timer
-   tick, otherwise false. */
+/* list_insert_ordered 함수에서 사용하기 위한 함수
+	deadline이 빠른 sleeper가 앞에 오도록 삽입하기 위한 함수 */
 static bool
-too_many_loops (unsigned loops) {
-	/* Wait for a timer tick. */
-	int64_t start = ticks;
-	while (ticks == start)
-		barrier ();
+hr_less (const struct list_elem *a_, const struct list_elem *b_,
+		void *aux UNUSED) {
+	const struct hr_sleeper *a = list_entry (a_, struct hr_sleeper, elem);
+	const struct hr_sleeper *b = list_entry (b_, struct hr_sleeper, elem);
 
-	/* Run LOOPS loops. */
-	start = ticks;
-	busy_wait (loops);
+	return (int64_t) (a->deadline - b->deadline) < 0;
+}
 
-	/* If the tick count changed, we iterated too long. */
-	barrier ();
-	return start != ticks;
+/* Blocks the current thread for NS nanoseconds, which should be
+   less than a tick.  The 8254 is reprogrammed at once if this
+   sleeper is now the first to wake. */
+static void
+hr_sleep (int64_t ns) {
+	struct hr_sleeper s;
+	enum intr_level old_level;
+
+	ASSERT (tsc_hz != 0);
+
+	s.deadline = rdtsc () + (uint64_t) ns * tsc_hz / 1000000000;
+	s.thread = thread_current ();
+
+	old_level = intr_disable ();
+	list_insert_ordered (&hr_sleepers, &s.elem, hr_less, NULL);
+	if (list_front (&hr_sleepers) == &s.elem)
+		timer_program ();
+	thread_block ();
+	intr_set_level (old_level);
 }
 
-/* Iterates through a simple loop LOOPS times, for implementing
-   brief delays.
+/* Wakes every high-resolution sleeper whose deadline is at or
+   before TSC value NOW.  Returns true if any thread was woken. */
+static bool
+hr_wake (uint64_t now) {
+	bool woken = false;
 
-   Marked NO_INLINE because code alignment can significantly
-   affect timings, so that if this function was inlined
-   differently in different places the results would be difficult
-   to predict. */
-static void NO_INLINE
-busy_wait (int64_t loops) {
-	while (loops-- > 0)
-		barrier ();
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (!list_empty (&hr_sleepers)) {
+		struct hr_sleeper *s = list_entry (list_front (&hr_sleepers),
+				struct hr_sleeper, elem);
+
+		if ((int64_t) (now - s->deadline) < 0)
+			break;
+		list_pop_front (&hr_sleepers);
+		thread_unblock (s->thread);
+		woken = true;
+	}
+	return woken;
+}
+
+/* Puts EV into the wheel slot that covers its deadline.
+   Deadlines too far in the future are parked in the last slot
+   of the top level and re-examined whenever it cascades. */
+static void
+wheel_insert (struct timer_event *ev) {
+	int64_t deadline = ev->deadline < wheel_tick ? wheel_tick : ev->deadline;
+	int64_t delta = deadline - wheel_tick;
+	int level;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (delta >= WHEEL_RANGE) {
+		deadline = wheel_tick + WHEEL_RANGE - 1;
+		delta = WHEEL_RANGE - 1;
+	}
+	for (level = 0; level < WHEEL_LEVELS - 1; level++)
+		if (delta < 1LL << (WHEEL_BITS * (level + 1)))
+			break;
+
+	list_push_back (&wheel[level][(deadline >> (WHEEL_BITS * level)) & WHEEL_MASK],
+			&ev->elem);
+}
+
+/* Runs every timer that expires up to and including the
+   current tick.  Returns true if at least one timer expired.
+   Each callback runs with interrupts off, but interrupts that
+   arrive meanwhile are let in between callbacks, so the window
+   with interrupts off stays one callback long however many
+   timers expire at once. */
+static bool
+wheel_advance (void) {
+	enum intr_level old_level;
+	bool fired = false;
+
+	old_level = intr_disable ();
+	while (wheel_tick <= ticks) {
+		int64_t tick = wheel_tick;
+		struct list expired;
+
+		/* Whenever a level wraps around, move the timers of the
+		   next level's current slot down to where they belong. */
+		for (int level = 1; level < WHEEL_LEVELS; level++) {
+			struct list *slot;
+
+			if ((tick & ((1LL << (WHEEL_BITS * level)) - 1)) != 0)
+				break;
+
+			slot = &wheel[level][(tick >> (WHEEL_BITS * level)) & WHEEL_MASK];
+			while (!list_empty (slot))
+				wheel_insert (list_entry (list_pop_front (slot),
+							struct timer_event, elem));
+		}
+
+		/* Detach the expired slot before running the callbacks, so
+		   that a callback re-arming its timer lands on the next
+		   tick instead of this one. */
+		list_init (&expired);
+		struct list *slot = &wheel[0][tick & WHEEL_MASK];
+		while (!list_empty (slot))
+			list_push_back (&expired, list_pop_front (slot));
+		wheel_tick++;
+
+		while (!list_empty (&expired)) {
+			struct timer_event *ev = list_entry (list_pop_front (&expired),
+					struct timer_event, elem);
+
+			ASSERT (ev->deadline <= tick);
+			ev->armed = false;
+			ev->func (ev->aux);
+			fired = true;
+
+			/* timer_cancel()은 EXPIRED에 남은 timer도 list_remove로
+			   뺄 수 있으므로 여기서 인터럽트를 받아도 된다 */
+			intr_set_level (old_level);
+			intr_disable ();
+		}
+	}
+	intr_set_level (old_level);
+
+	return fired;
+}
+
+/* Returns the earliest tick on which a timer in the wheel may
+   need attention, or INT64_MAX if the wheel is empty.  Timers on
+   the upper levels are only looked at when level 0 wraps, so if
+   there are any, the next wrap counts as well. */
+static int64_t
+wheel_next_deadline (void) {
+	int64_t next = INT64_MAX;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (int i = 0; i < WHEEL_SIZE; i++) {
+		int64_t tick = wheel_tick + i;
+
+		if (!list_empty (&wheel[0][tick & WHEEL_MASK])) {
+			next = tick;
+			break;
+		}
+	}
+	for (int level = 1; level < WHEEL_LEVELS; level++)
+		for (int slot = 0; slot < WHEEL_SIZE; slot++)
+			if (!list_empty (&wheel[level][slot])) {
+				int64_t wrap = (wheel_tick | WHEEL_MASK) + 1;
+				return wrap < next ? wrap : next;
+			}
+	return next;
 }
 
 /* Sleep for approximately NUM/DENOM seconds. */
@@ -179,11 +542,14 @@ real_time_sleep (int64_t num, int32_t denom) {
 		   timer_sleep() because it will yield the CPU to other
 		   processes. */
 		timer_sleep (ticks);
-	} else {
-		/* Otherwise, use a busy-wait loop for more accurate
-		   sub-tick timing.  We scale the numerator and denominator
-		   down by 1000 to avoid the possibility of overflow. */
-		ASSERT (denom % 1000 == 0);
-		busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+	} else if (num > 0) {
+		/* Otherwise block until the one-shot timer wakes us at the
+		   exact deadline.  NUM is less than DENOM / TIMER_FREQ here,
+		   so converting to nanoseconds cannot overflow.  Before the
+		   TSC is calibrated, round up to a whole tick instead. */
+		if (tsc_hz != 0)
+			hr_sleep (num * 1000000000 / denom);
+		else
+			timer_sleep (1);
 	}
 }
@@ -6,6 +6,7 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -50,13 +51,37 @@ byte_to_sector (const struct inode *inode, off_t pos) {
 }
 
 /* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
+ * returns the same `struct inode'.  Lookups, which are the
+ * common case, only take OPEN_INODES_LOCK for reading. */
 static struct list open_inodes;
+static struct rwlock open_inodes_lock;
+
+/* Cache of in-memory inodes. */
+static struct kmem_cache *inode_cache;
 
 /* Initializes the inode module. */
 void
 inode_init (void) {
 	list_init (&open_inodes);
+	rwlock_init (&open_inodes_lock);
+	inode_cache = kmem_cache_create ("inode", sizeof (struct inode), 0, NULL);
+	if (inode_cache == NULL)
+		PANIC ("inode cache creation failed");
+}
+
+/* Returns the open inode for SECTOR, reopened, or a null
+ * pointer if it is not open.  OPEN_INODES_LOCK must be held. */
+static struct inode *
+open_inodes_lookup (disk_sector_t sector) {
+	struct list_elem *e;
+
+	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
+			e = list_next (e)) {
+		struct inode *inode = list_entry (e, struct inode, elem);
+		if (inode->sector == sector)
+			return inode_reopen (inode);
+	}
+	return NULL;
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -101,23 +126,35 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
 	struct inode *inode;
 
 	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
+	rwlock_read_acquire (&open_inodes_lock);
+	inode = open_inodes_lookup (sector);
+	if (inode != NULL) {
+		rwlock_read_release (&open_inodes_lock);
+		return inode;
+	}
+
+	/* Not open: we need to insert it.  If another reader is
+	 * already upgrading, fall back to a plain write acquire, and
+	 * check again since someone may have opened it meanwhile. */
+	if (!rwlock_upgrade (&open_inodes_lock)) {
+		rwlock_read_release (&open_inodes_lock);
+		rwlock_write_acquire (&open_inodes_lock);
+		inode = open_inodes_lookup (sector);
+		if (inode != NULL) {
+			rwlock_write_release (&open_inodes_lock);
+			return inode;
 		}
 	}
 
 	/* Allocate memory. */
-	inode = malloc (sizeof *inode);
-	if (inode == NULL)
+	inode = kmem_cache_alloc (inode_cache);
+	if (inode == NULL) {
+		rwlock_write_release (&open_inodes_lock);
 		return NULL;
+	}
 
 	/* Initialize. */
 	list_push_front (&open_inodes, &inode->elem);
@@ -126,14 +163,16 @@ inode_open (disk_sector_t sector) {
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
 	disk_read (filesys_disk, inode->sector, &inode->data);
+	rwlock_write_release (&open_inodes_lock);
 	return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
+	/* May run with OPEN_INODES_LOCK held only for reading. */
 	if (inode != NULL)
-		inode->open_cnt++;
+		__sync_fetch_and_add (&inode->open_cnt, 1);
 	return inode;
 }
 
@@ -153,9 +192,11 @@ inode_close (struct inode *inode) {
 		return;
 
 	/* Release resources if this was the last opener. */
+	rwlock_write_acquire (&open_inodes_lock);
 	if (--inode->open_cnt == 0) {
 		/* Remove from inode list and release lock. */
 		list_remove (&inode->elem);
+		rwlock_write_release (&open_inodes_lock);
 
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
@@ -164,8 +205,9 @@ inode_close (struct inode *inode) {
 					bytes_to_sectors (inode->data.length)); 
 		}
 
-		free (inode); 
-	}
+		kmem_cache_free (inode_cache, inode);
+	} else
+		rwlock_write_release (&open_inodes_lock);
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -7,6 +7,8 @@
 void input_init (void);
 void input_putc (uint8_t);
 uint8_t input_getc (void);
+bool input_getc_killable (uint8_t *);
 bool input_full (void);
+bool input_empty (void);
 
 #endif /* devices/input.h */
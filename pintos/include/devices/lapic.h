@@ -0,0 +1,22 @@
+#ifndef DEVICES_LAPIC_H
+#define DEVICES_LAPIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Interrupt vectors raised by the local APIC.  Vectors 0x30...0x3f
+   are external interrupts like the PIC's 0x20...0x2f, but they
+   are acknowledged on the local APIC instead. */
+#define LAPIC_TIMER_VEC 0x30            /* Timer of an application processor. */
+#define LAPIC_RESCHED_VEC 0x31          /* "Look for a thread to run." */
+#define LAPIC_TLB_VEC 0x32              /* TLB shootdown; see cpu.c. */
+#define LAPIC_SPURIOUS_VEC 0xff         /* Spurious interrupt. */
+
+void lapic_init (uint64_t pa);
+void lapic_init_ap (void);
+uint8_t lapic_id (void);
+void lapic_eoi (void);
+void lapic_send_ipi (uint8_t lapic_id, uint8_t vec);
+void lapic_start_ap (uint8_t lapic_id, uint64_t entry);
+
+#endif /* devices/lapic.h */
@@ -1,14 +1,32 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* Function called when a kernel timer expires.
+   Runs in the timer interrupt context, so it must not sleep. */
+typedef void timer_func (void *aux);
+
+/* A kernel timer.  Embed one in the object that needs a timeout
+   and arm it with timer_arm(). */
+struct timer_event {
+	int64_t deadline;           /* Tick on which FUNC is called. */
+	timer_func *func;           /* Function to call. */
+	void *aux;                  /* Argument for FUNC. */
+	bool armed;                 /* Waiting in the timer wheel? */
+	struct list_elem elem;      /* Timer wheel slot element. */
+};
+
 void timer_init (void);
 void timer_calibrate (void);
+uint64_t timer_tsc_hz (void);
+uint64_t timer_tsc_to_ns (uint64_t cycles);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
@@ -18,6 +36,13 @@ void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
 
+void timer_arm (struct timer_event *, int64_t deadline,
+                timer_func *, void *aux);
+bool timer_cancel (struct timer_event *);
+
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
 void timer_print_stats (void);
 
 #endif /* devices/timer.h */
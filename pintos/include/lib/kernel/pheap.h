@@ -0,0 +1,66 @@
+#ifndef __LIB_KERNEL_PHEAP_H
+#define __LIB_KERNEL_PHEAP_H
+
+/* Pairing heap.
+ *
+ * A max-heap that, like our lists and hash tables, does no
+ * dynamic allocation: each structure that can be in a heap
+ * embeds a struct pheap_elem, and pheap_entry() converts a
+ * pointer to that member back to the containing structure.
+ *
+ * pheap_top() is O(1).  pheap_push() is O(1), and pheap_pop(),
+ * pheap_remove() and pheap_update() are amortized O(log n).
+ * An element's key may only be changed while it is in the heap
+ * if pheap_update() is called right afterward. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Pairing heap element. */
+struct pheap_elem {
+	struct pheap_elem *child;   /* Leftmost child. */
+	struct pheap_elem *next;    /* Next sibling. */
+	struct pheap_elem *prev;    /* Previous sibling, or parent if leftmost. */
+};
+
+/* Compares the value of two heap elements A and B, given
+ * auxiliary data AUX.  Returns true if A is less than B, or
+ * false if A is greater than or equal to B. */
+typedef bool pheap_less_func (const struct pheap_elem *a,
+                              const struct pheap_elem *b,
+                              void *aux);
+
+/* Performs some operation on heap element E, given auxiliary
+ * data AUX. */
+typedef void pheap_action_func (struct pheap_elem *e, void *aux);
+
+/* Pairing heap. */
+struct pheap {
+	struct pheap_elem *root;    /* Greatest element, or null. */
+	size_t size;                /* Number of elements. */
+	pheap_less_func *less;      /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+/* Converts pointer to heap element PHEAP_ELEM into a pointer to
+ * the structure that PHEAP_ELEM is embedded inside.  Supply the
+ * name of the outer structure STRUCT and the member name MEMBER
+ * of the heap element. */
+#define pheap_entry(PHEAP_ELEM, STRUCT, MEMBER)                 \
+	((STRUCT *) ((uint8_t *) &(PHEAP_ELEM)->child           \
+		- offsetof (STRUCT, MEMBER.child)))
+
+void pheap_init (struct pheap *, pheap_less_func *, void *aux);
+bool pheap_empty (const struct pheap *);
+size_t pheap_size (const struct pheap *);
+struct pheap_elem *pheap_top (const struct pheap *);
+
+void pheap_push (struct pheap *, struct pheap_elem *);
+struct pheap_elem *pheap_pop (struct pheap *);
+void pheap_remove (struct pheap *, struct pheap_elem *);
+void pheap_update (struct pheap *, struct pheap_elem *);
+
+void pheap_for_each (struct pheap *, pheap_action_func *, void *aux);
+
+#endif /* lib/kernel/pheap.h */
@@ -0,0 +1,62 @@
+#ifndef __LIB_KERNEL_RBTREE_H
+#define __LIB_KERNEL_RBTREE_H
+
+/* Red-black tree.
+ *
+ * A balanced binary search tree that, like our lists and heaps,
+ * does no dynamic allocation: each structure that can be in a
+ * tree embeds a struct rb_node, and rb_entry() converts a
+ * pointer to that member back to the containing structure.
+ *
+ * rb_insert() and rb_remove() are O(log n).  The leftmost
+ * (smallest) node is cached, so rb_first() is O(1).  Equal keys
+ * are allowed; a node is inserted after the nodes it compares
+ * equal to.  A node's key must not change while it is in a
+ * tree; remove it, change the key and insert it again. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Red-black tree node. */
+struct rb_node {
+	struct rb_node *parent;     /* Parent, or null for the root. */
+	struct rb_node *left;       /* Left child. */
+	struct rb_node *right;      /* Right child. */
+	bool red;                   /* Red or black? */
+};
+
+/* Compares the value of two tree nodes A and B, given
+ * auxiliary data AUX.  Returns true if A is less than B, or
+ * false if A is greater than or equal to B. */
+typedef bool rb_less_func (const struct rb_node *a,
+                           const struct rb_node *b,
+                           void *aux);
+
+/* Red-black tree. */
+struct rbtree {
+	struct rb_node *root;       /* Root node, or null. */
+	struct rb_node *first;      /* Leftmost node, or null. */
+	size_t size;                /* Number of nodes. */
+	rb_less_func *less;         /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+/* Converts pointer to tree node RB_NODE into a pointer to the
+ * structure that RB_NODE is embedded inside.  Supply the name
+ * of the outer structure STRUCT and the member name MEMBER of
+ * the tree node. */
+#define rb_entry(RB_NODE, STRUCT, MEMBER)                       \
+	((STRUCT *) ((uint8_t *) &(RB_NODE)->parent             \
+		- offsetof (STRUCT, MEMBER.parent)))
+
+void rb_init (struct rbtree *, rb_less_func *, void *aux);
+bool rb_empty (const struct rbtree *);
+size_t rb_size (const struct rbtree *);
+struct rb_node *rb_first (const struct rbtree *);
+struct rb_node *rb_next (const struct rb_node *);
+
+void rb_insert (struct rbtree *, struct rb_node *);
+void rb_remove (struct rbtree *, struct rb_node *);
+
+#endif /* lib/kernel/rbtree.h */
@@ -0,0 +1,30 @@
+#ifndef __LIB_LOCKSTAT_H
+#define __LIB_LOCKSTAT_H
+
+#include <stdint.h>
+
+/* Lock contention statistics.
+
+   When the kernel is built with -DLOCKSTAT in DEFINES (see the
+   Make.vars of each project directory), every lock initialized
+   with lock_init_named() records the statistics below.  Locks
+   that share a name share one entry, so e.g. all inode locks
+   can be summed up under a single name.  All times are in
+   timer ticks.
+
+   User programs read the table with the lockstat() system
+   call; the kernel prints it at power off. */
+
+#define LOCKSTAT_NAME_LEN 16    /* Including null terminator. */
+
+struct lockstat {
+	char name[LOCKSTAT_NAME_LEN];   /* Lock name. */
+	uint64_t acquired;              /* Number of acquires. */
+	uint64_t contended;             /* Acquires that had to wait. */
+	uint64_t wait_ticks;            /* Total time spent waiting. */
+	uint64_t max_wait_ticks;        /* Longest single wait. */
+	uint64_t hold_ticks;            /* Total time held. */
+	uint64_t max_hold_ticks;        /* Longest single hold. */
+};
+
+#endif /* lib/lockstat.h */
@@ -0,0 +1,25 @@
+#ifndef __LIB_RUSAGE_H
+#define __LIB_RUSAGE_H
+
+#include <stdint.h>
+
+/* CPU usage of a thread or a process.
+
+   The kernel measures each thread with the TSC whenever it is
+   scheduled, enters the kernel from user mode and returns to
+   user mode.  User programs read the numbers with the
+   getrusage() system call.  All times are in nanoseconds. */
+
+/* Values for the WHO argument of getrusage(). */
+#define RUSAGE_SELF 0           /* All threads of the calling process. */
+#define RUSAGE_THREAD 1         /* The calling thread only. */
+
+struct rusage {
+	uint64_t ru_utime;          /* Time running in user mode. */
+	uint64_t ru_stime;          /* Time running in the kernel. */
+	uint64_t ru_wtime;          /* Time runnable but waiting for a CPU. */
+	uint64_t ru_nvcsw;          /* Switches away by blocking. */
+	uint64_t ru_nivcsw;         /* Switches away by preemption. */
+};
+
+#endif /* lib/rusage.h */
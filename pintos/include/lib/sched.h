@@ -0,0 +1,29 @@
+#ifndef __LIB_SCHED_H
+#define __LIB_SCHED_H
+
+/* Scheduling classes.
+
+   SCHED_OTHER threads are scheduled by the round-robin, MLFQS or
+   CFS scheduler chosen at boot.  SCHED_FIFO threads sit above all
+   of them: a runnable SCHED_FIFO thread always runs before any
+   SCHED_OTHER thread, higher rt_priority first, and keeps the CPU
+   until it blocks, yields or is preempted by a higher one.
+
+   To keep a runaway SCHED_FIFO thread from starving the system,
+   the class as a whole may only use part of each period; see
+   RT_RUNTIME in threads/thread.c.  Once that budget is gone, the
+   class is demoted below SCHED_OTHER until the next period. */
+
+/* Values for the POLICY argument of sched_setscheduler(). */
+#define SCHED_OTHER 0           /* Normal time-sharing. */
+#define SCHED_FIFO 1            /* Real-time, first in first out. */
+
+/* Range of rt_priority for SCHED_FIFO.  SCHED_OTHER uses 0.
+   User programs may only go up to SCHED_RT_PRIO_USER_MAX; the
+   band above it is kept for kernel threads such as ksoftirqd, so
+   that a user thread can never run ahead of them. */
+#define SCHED_RT_PRIO_MIN 1     /* Lowest real-time priority. */
+#define SCHED_RT_PRIO_USER_MAX 89 /* Highest for user programs. */
+#define SCHED_RT_PRIO_MAX 99    /* Highest real-time priority. */
+
+#endif /* lib/sched.h */
@@ -36,6 +36,24 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Profiling. */
+	SYS_LOCKSTAT,               /* Read lock contention statistics. */
+
+	/* User-space synchronization. */
+	SYS_FUTEX_WAIT,             /* Sleep if a word has a given value. */
+	SYS_FUTEX_WAKE,             /* Wake threads sleeping on a word. */
+
+	/* User threads. */
+	SYS_THREAD_CREATE,          /* Start a thread in this process. */
+	SYS_THREAD_JOIN,            /* Wait for a thread to exit. */
+	SYS_THREAD_EXIT,            /* Terminate this thread. */
+
+	/* CPU accounting. */
+	SYS_GETRUSAGE,              /* Read CPU usage statistics. */
+
+	/* Scheduling. */
+	SYS_SCHED_SETSCHEDULER,     /* Change the scheduling class. */
 };
 
 #endif /* lib/syscall-nr.h */
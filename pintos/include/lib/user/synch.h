@@ -0,0 +1,37 @@
+#ifndef __LIB_USER_SYNCH_H
+#define __LIB_USER_SYNCH_H
+
+#include <stdbool.h>
+
+/* User-space mutexes and condition variables.
+
+   Both are built on futex_wait() and futex_wake(): an
+   uncontended mutex_lock() or mutex_unlock() is a single atomic
+   instruction and does not enter the kernel. */
+
+/* Mutex. */
+struct mutex {
+	volatile int state;         /* 0: unlocked, 1: locked,
+	                               2: locked, maybe with waiters. */
+};
+
+#define MUTEX_INITIALIZER { 0 }
+
+void mutex_init (struct mutex *);
+void mutex_lock (struct mutex *);
+bool mutex_trylock (struct mutex *);
+void mutex_unlock (struct mutex *);
+
+/* Condition variable. */
+struct condvar {
+	volatile int seq;           /* Bumped by every signal. */
+};
+
+#define CONDVAR_INITIALIZER { 0 }
+
+void condvar_init (struct condvar *);
+void condvar_wait (struct condvar *, struct mutex *);
+void condvar_signal (struct condvar *);
+void condvar_broadcast (struct condvar *);
+
+#endif /* lib/user/synch.h */
@@ -4,11 +4,21 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <lockstat.h>
+#include <rusage.h>
+#include <sched.h>
 
 /* Process identifier. */
 typedef int pid_t;
 #define PID_ERROR ((pid_t) -1)
 
+/* Thread identifier. */
+typedef int tid_t;
+#define TID_ERROR ((tid_t) -1)
+
+/* Function run by a thread made with thread_create(). */
+typedef void thread_func (void *aux);
+
 /* Map region identifier. */
 typedef int off_t;
 #define MAP_FAILED ((void *) NULL)
@@ -50,6 +60,24 @@ bool isdir (int fd);
 int inumber (int fd);
 int symlink (const char* target, const char* linkpath);
 
+/* Profiling. */
+int lockstat (struct lockstat *buf, int cnt);
+int getrusage (int who, struct rusage *ru);
+
+/* Scheduling.  See <sched.h>.  Applies to the calling thread. */
+int sched_setscheduler (int policy, int rt_priority);
+
+/* User-space synchronization.  See <synch.h> for locks built on
+   these. */
+int futex_wait (const int *addr, int expected);
+int futex_wake (const int *addr, int n);
+
+/* User threads.  Threads of a process share its memory and open
+   files; exit() from any of them ends the whole process. */
+tid_t thread_create (thread_func *function, void *aux);
+int thread_join (tid_t tid);
+void thread_exit (int status) NO_RETURN;
+
 static inline void* get_phys_addr (void *user_addr) {
 	void* pa;
 	asm volatile ("movq %0, %%rax" ::"r"(user_addr));
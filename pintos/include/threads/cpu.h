@@ -0,0 +1,111 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+/* Offsets in struct cpu of the members that assembly code reaches
+   through %gs.  cpu.c checks that they match the struct. */
+#define CPU_SELF 0                      /* struct cpu *self. */
+#define CPU_SCRATCH 8                   /* uint64_t scratch. */
+#define CPU_TSS 16                      /* struct task_state *tss. */
+
+/* Physical address that application processors start at, in real
+   mode.  Must be page aligned, below 1 MB, and not used by
+   anything else; see mpboot.S. */
+#define AP_TRAMPOLINE 0x8000
+
+#ifndef __ASSEMBLER__
+#include <list.h>
+#include <rbtree.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Maximum number of CPUs. */
+#define NCPU_MAX 8
+
+/* A per-CPU run queue.
+   priority 마다 FIFO list를 하나씩 두고, bitmap의 N번째 bit로
+   queues[N]이 비어있지 않은지를 표시한다.
+   가장 높은 priority는 bitmap에서 가장 높은 bit를 찾는 것으로 구할 수 있다.
+   CFS에서는 queues 대신 vruntime 순서의 red-black tree를 사용한다. */
+struct runqueue {
+	struct spinlock lock;               /* Protects the members below. */
+	struct list queues[PRI_MAX + 1];    /* THREAD_READY threads per priority. */
+	uint64_t bitmap;                    /* Bit N set if queues[N] is nonempty. */
+	size_t cnt;                         /* # of threads in the queues. */
+
+	/* CFS only. */
+	struct rbtree cfs_tree;             /* THREAD_READY threads by vruntime. */
+	uint64_t min_vruntime;              /* Never decreasing floor of vruntime. */
+	uint64_t load;                      /* Sum of the weights in cfs_tree. */
+
+	/* SCHED_FIFO threads, run before every other class. */
+	struct list rt_queue;               /* By rt_priority, FIFO among equals. */
+	size_t rt_cnt;                      /* # of threads in rt_queue. */
+	int64_t rt_period_start;            /* Tick the current period began. */
+	unsigned rt_ticks;                  /* Ticks used by SCHED_FIFO this period. */
+	bool rt_throttled;                  /* Budget used up until next period? */
+};
+
+/* Per-CPU state.  The GS base of each CPU points to its own
+   struct cpu while it runs in the kernel.  Everything in here is
+   only touched by its own CPU, except the run queue, which other
+   CPUs may steal from while holding its lock, and the TLB
+   shootdown request, which the CPU holding the big kernel lock
+   posts. */
+struct cpu {
+	/* Used by assembly code; see CPU_* above. */
+	struct cpu *self;                   /* This struct, for this_cpu(). */
+	uint64_t scratch;                   /* User rsp, saved by syscall_entry. */
+	struct task_state *tss;             /* TSS holding this CPU's rsp0. */
+
+	int id;                             /* CPU number, index into cpus[]. */
+	uint8_t lapic_id;                   /* Local APIC ID. */
+	struct thread *curr;                /* Thread running on this CPU. */
+	struct thread *idle_thread;         /* This CPU's idle thread. */
+	unsigned thread_ticks;              /* # of timer ticks since last yield. */
+	struct spinlock *switch_unlock;     /* Released after the next switch. */
+
+	/* Statistics. */
+	long long idle_ticks;               /* # of timer ticks spent idle. */
+	long long kernel_ticks;             /* # of timer ticks in kernel threads. */
+	long long user_ticks;               /* # of timer ticks in user programs. */
+
+	/* TLB shootdown. */
+	volatile bool tlb_pending;          /* tlb_va must be invalidated. */
+	volatile uint64_t tlb_va;           /* User page to invalidate. */
+
+	struct runqueue rq;                 /* Ready threads of this CPU. */
+};
+
+extern struct cpu cpus[NCPU_MAX];
+extern int cpu_cnt;
+
+void cpu_init (void);
+void cpu_start_aps (void);
+bool cpu_all_idle (void);
+void cpu_kick_idle (void);
+void cpu_tlb_shootdown (uint64_t *pml4, const void *va);
+void cpu_tlb_flush (void);
+
+/* Returns the CPU we are running on.  The caller must keep
+   interrupts off for as long as it uses the result, or the
+   thread may move to another CPU. */
+static inline struct cpu *
+this_cpu (void) {
+	struct cpu *c;
+
+	asm volatile ("movq %%gs:0, %0" : "=r" (c));
+	return c;
+}
+
+/* Big kernel lock.  Held by whichever CPU runs kernel code. */
+void bkl_acquire (void);
+void bkl_release (void);
+void bkl_exit (void);
+void bkl_handoff (void);
+bool bkl_held (void);
+
+#endif /* __ASSEMBLER__ */
+#endif /* threads/cpu.h */
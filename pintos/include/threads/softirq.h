@@ -0,0 +1,41 @@
+#ifndef THREADS_SOFTIRQ_H
+#define THREADS_SOFTIRQ_H
+
+#include <stdbool.h>
+
+/* Softirqs: deferred halves of interrupt handlers.
+
+   An external interrupt handler runs with interrupts off, so
+   everything it does lengthens the time the CPU ignores other
+   devices.  A handler should do only what must happen at once
+   (acknowledging the device, reading its status) and raise a
+   softirq for the rest.  Raised softirqs run right before
+   intr_handler() returns, after the PIC has been acknowledged,
+   with interrupts enabled.
+
+   A softirq handler may be interrupted but never runs
+   concurrently with itself or with another softirq handler.  It
+   must not sleep.  It may unblock threads and call
+   thread_maybe_yield(); the yield then happens once every
+   pending softirq has run.  If softirqs keep being raised while
+   they run, the rest is left to the "ksoftirqd" kernel thread
+   so that the interrupted thread is not held up indefinitely.
+
+   Softirqs are fixed at compile time; add one to the enum below
+   for each subsystem that needs one.  Lower numbers run first. */
+enum softirq {
+	SOFTIRQ_TIMER,              /* Expired kernel timers. */
+	SOFTIRQ_BLOCK,              /* Disk request completion. */
+	SOFTIRQ_CNT                 /* Number of softirqs. */
+};
+
+typedef void softirq_func (void *aux);
+
+void softirq_register (enum softirq, softirq_func *, void *aux);
+void softirq_raise (enum softirq);
+void softirq_run (void);
+void softirq_start (void);
+bool softirq_context (void);
+void softirq_print_stats (void);
+
+#endif /* threads/softirq.h */
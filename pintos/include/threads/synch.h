@@ -2,16 +2,35 @@
 #define THREADS_SYNCH_H
 
 #include <list.h>
+#include <lockstat.h>
+#include <pheap.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct thread;
+
+/* Spinlock.
+   Must be held with interrupts off, and never across a sleep. */
+struct spinlock {
+	volatile int locked;        /* Nonzero while held. */
+};
+
+void spinlock_init (struct spinlock *);
+void spin_lock (struct spinlock *);
+void spin_unlock (struct spinlock *);
 
 /* A counting semaphore. */
 struct semaphore {
+	struct spinlock lock;       /* Protects VALUE and WAITERS. */
 	unsigned value;             /* Current value. */
-	struct list waiters;        /* List of waiting threads. */
+	struct pheap waiters;       /* Waiting threads, highest priority on top. */
 };
 
 void sema_init (struct semaphore *, unsigned value);
 void sema_down (struct semaphore *);
+bool sema_down_killable (struct semaphore *);
+void sema_kill (struct thread *);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
@@ -20,17 +39,61 @@ void sema_self_test (void);
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+#ifdef LOCKSTAT
+	struct lockstat *stat;      /* Statistics entry, or null if unnamed. */
+	int64_t acquire_time;       /* Timer ticks when last acquired. */
+#endif
 };
 
+/* Maximum number of nested locks walked when donating
+   priority.  Controlled by kernel command-line option
+   "-donate-depth=N". */
+extern int lock_donate_depth;
+
 void lock_init (struct lock *);
+void lock_init_named (struct lock *, const char *name);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
+bool lock_stat_get (size_t idx, struct lockstat *);
+void lock_print_stats (void);
+
+/* Reader-writer lock.
+   Any number of readers, or a single writer, may hold it. */
+struct rwlock {
+	struct thread *writer;      /* Exclusive holder, or null. */
+	size_t readers;             /* Number of shared holders. */
+	struct thread *upgrader;    /* Reader waiting in rwlock_upgrade(). */
+	struct list holders;        /* struct rw_hold of every holder. */
+	struct list read_waiters;   /* Threads waiting to read. */
+	struct list write_waiters;  /* Threads waiting to write. */
+	int donation;               /* Highest priority among waiters. */
+};
+
+/* Maximum number of rwlocks a thread may hold at once. */
+#define RW_HOLD_MAX 4
+
+/* One rwlock held by a thread.  Kept in `struct thread' so that
+   a rwlock can find all of its readers to donate priority to. */
+struct rw_hold {
+	struct rwlock *lock;        /* Held rwlock, or null if unused. */
+	struct thread *thread;      /* Holding thread. */
+	struct list_elem elem;      /* Element in lock->holders. */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_read_acquire (struct rwlock *);
+void rwlock_read_release (struct rwlock *);
+void rwlock_write_acquire (struct rwlock *);
+void rwlock_write_release (struct rwlock *);
+bool rwlock_upgrade (struct rwlock *);
+void rwlock_downgrade (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
 
 /* Condition variable. */
 struct condition {
-	struct list waiters;        /* List of waiting threads. */
+	struct pheap waiters;       /* Waiters, highest priority on top. */
 };
 
 void cond_init (struct condition *);
@@ -38,6 +101,8 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+void synch_requeue (struct thread *);
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
@@ -3,14 +3,23 @@
 
 #include <debug.h>
 #include <list.h>
+#include <pheap.h>
+#include <rbtree.h>
+#include <rusage.h>
+#include <sched.h>
 #include <stdint.h>
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/fixed-point.h"
+#include "devices/timer.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
 
 
+struct cpu;
+struct process;
+
 /* States in a thread's life cycle. */
 enum thread_status {
 	THREAD_RUNNING,     /* Running thread. */
@@ -29,6 +38,11 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Thread nice values. */
+#define NICE_MIN -20                    /* Nicest. */
+#define NICE_DEFAULT 0                  /* Default nice. */
+#define NICE_MAX 20                     /* Least nice. */
+
 /* 프로세스마다 파일 디스크립터를 관리하기 위한 구조체 */
 struct fd_table {
 	int fd_next;
@@ -97,27 +111,72 @@ struct child_state {
  * value, triggering the assertion. */
 /* The `elem' member has a dual purpose.  It can be an element in
  * the run queue (thread.c), or it can be an element in a
- * semaphore wait list (synch.c).  It can be used these two ways
+ * rwlock wait list (synch.c).  It can be used these two ways
  * only because they are mutually exclusive: only a thread in the
  * ready state is on the run queue, whereas only a thread in the
- * blocked state is on a semaphore wait list. */
+ * blocked state is on a wait list.  Semaphores and condition
+ * variables keep their waiters in heaps through `wait_elem' and
+ * the waiter's semaphore_elem instead. */
 struct thread {
 	/* Owned by thread.c. */
 	tid_t tid;                          /* Thread identifier. */
 	enum thread_status status;          /* Thread state. */
-	int64_t awake_ticks;
+	struct timer_event sleep_timer;     /* thread_sleep에서 사용하는 timer */
 	char name[16];                      /* Name (for debugging purposes). */
-	int priority;                       /* Priority. */
+	int priority;                       /* Effective priority. */
+
+	/* Shared between thread.c and synch.c, used for donation. */
+	int base_priority;                  /* Priority without donations. */
+	struct lock *wait_on_lock;          /* Lock we are waiting for. */
+	struct pheap donors;                /* Threads waiting on our locks. */
+	struct pheap_elem donor_elem;       /* Element in holder's donors. */
+	struct rwlock *wait_on_rwlock;      /* Rwlock we are waiting for. */
+	struct rw_hold rw_holds[RW_HOLD_MAX]; /* Rwlocks we hold. */
+
+	/* Owned by thread.c, used by the MLFQS scheduler. */
+	int nice;                           /* Niceness. */
+	fixed_t recent_cpu;                 /* Recent CPU usage. */
+	bool mlfqs_active;                  /* In mlfqs_list? */
+	struct list_elem mlfqs_elem;        /* mlfqs_list element. */
+
+	/* Owned by thread.c, used by the CFS scheduler. */
+	uint64_t vruntime;                  /* Weighted run time in TSC cycles. */
+	uint64_t exec_stamp;                /* When vruntime was last charged. */
+	uint64_t slice_exec;                /* Run time in the current slice. */
+	struct rb_node cfs_node;            /* Element in the CFS run queue. */
+
+	/* Owned by thread.c, scheduling class.  See <sched.h>. */
+	int policy;                         /* SCHED_OTHER or SCHED_FIFO. */
+	int rt_priority;                    /* SCHED_FIFO priority, else 0. */
+
+	struct cpu *cpu;                    /* CPU whose run queue holds us. */
+
+	/* Owned by thread.c, CPU accounting in TSC cycles. */
+	uint64_t acct_stamp;                /* Start of the current interval. */
+	uint64_t ready_stamp;               /* When we last became ready. */
+	uint64_t utime;                     /* Time running in user mode. */
+	uint64_t stime;                     /* Time running in the kernel. */
+	uint64_t wtime;                     /* Time ready but not running. */
+	uint64_t nvcsw;                     /* Voluntary context switches. */
+	uint64_t nivcsw;                    /* Involuntary context switches. */
 
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;              /* List element. */
 
+	/* Owned by synch.c, used by priority wait queues. */
+	struct pheap_elem wait_elem;        /* Element in semaphore's waiters. */
+	struct semaphore *wait_sema;        /* Semaphore we are waiting on. */
+	struct condition *wait_cond;        /* Condition we are waiting on. */
+	struct pheap_elem *cond_waiter;     /* Our element in its waiters. */
+	uint64_t wait_seq;                  /* Keeps FIFO among equal priorities. */
+	bool wait_killable;                 /* In sema_down_killable()? */
+	bool killed;                        /* Set by sema_kill(). */
+
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
 	uint64_t *pml4;                     /* Page map level 4 */
-	struct fd_table fd_table;
-
-	struct file *current_file;
+	struct process *process;            /* Shared process state. */
+	int stack_slot;                     /* User stack slot, or -1. */
 
 	struct thread* process_parent;
 	struct list process_child_list;
@@ -130,11 +189,6 @@ struct thread {
 
 	int exit_status;
 #endif
-#ifdef VM
-	/* Table for whole virtual memory owned by thread. */
-	struct supplemental_page_table spt;
-#endif
-
 	/* Owned by thread.c. */
 	struct intr_frame tf;               /* Information for switching */
 	unsigned magic;                     /* Detects stack overflow. */
@@ -145,19 +199,32 @@ struct thread {
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the completely fair scheduler instead.
+   Controlled by kernel command-line option "-cfs". */
+extern bool thread_cfs;
+
+/* Maximum number of exited thread pages kept for reuse.
+   Controlled by kernel command-line option "-tc=N". */
+extern size_t thread_cache_max;
+
 void thread_init (void);
 void thread_start (void);
+void *thread_prepare_ap (struct cpu *);
+void thread_start_ap (void) NO_RETURN;
 
 void thread_tick (void);
 void thread_print_stats (void);
+void thread_charge_user (void);
+void thread_charge_system (void);
+void thread_rusage_add (struct thread *, struct rusage *);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
 
 void thread_block (void);
+void thread_block_locked (struct spinlock *);
 void thread_unblock (struct thread *);
 void thread_sleep (int64_t alarm_ticks);
-void thread_wakeup (int64_t current_ticks);
 
 struct thread *thread_current (void);
 tid_t thread_tid (void);
@@ -169,12 +236,16 @@ void thread_maybe_yield (void);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
+bool thread_refresh_priority (struct thread *);
 
 int thread_get_nice (void);
 void thread_set_nice (int);
 int thread_get_recent_cpu (void);
 int thread_get_load_avg (void);
 
+int thread_set_scheduler (int policy, int rt_priority);
+int thread_get_scheduler (void);
+
 void do_iret (struct intr_frame *tf);
 
 #endif /* threads/thread.h */
@@ -0,0 +1,69 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Kernel tracepoints.
+
+   When the kernel is started with "-trace", each TRACE() call
+   appends a record stamped with the TSC to a per-CPU ring
+   buffer.  Recording never takes a lock or touches the console,
+   so it barely perturbs timing.  When the buffer is full the
+   oldest records are overwritten.
+
+   At power off the records are written to the scratch disk
+   (hd1:0) starting at sector 0: one sector holding a `struct
+   trace_header', followed by the records of every CPU, oldest
+   first, packed back to back.  Do not combine "-trace" with
+   `get' actions, which also write to the scratch disk. */
+
+/* Traced events.  The meaning of the argument is noted. */
+enum trace_event {
+	TRACE_SCHEDULE,             /* Switch; tid of next thread. */
+	TRACE_BLOCK,                /* thread_block(); 0. */
+	TRACE_UNBLOCK,              /* thread_unblock(); tid woken. */
+	TRACE_INTR_ENTER,           /* intr_handler() entry; vector. */
+	TRACE_INTR_EXIT,            /* intr_handler() exit; vector. */
+	TRACE_DISK_READ,            /* disk_read(); sector. */
+	TRACE_DISK_WRITE,           /* disk_write(); sector. */
+	TRACE_PAGE_FAULT,           /* Page fault; faulting address. */
+	TRACE_SYSCALL,              /* System call; call number. */
+};
+
+/* One trace record, 24 bytes. */
+struct trace_record {
+	uint64_t tsc;               /* Time stamp counter. */
+	uint16_t event;             /* enum trace_event. */
+	uint16_t cpu;               /* CPU id. */
+	int32_t tid;                /* Running thread. */
+	uint64_t arg;               /* Event-specific argument. */
+};
+
+/* Dump header, at the start of the first sector. */
+struct trace_header {
+	char magic[4];              /* "TRC\0". */
+	uint32_t record_size;       /* sizeof (struct trace_record). */
+	uint64_t record_cnt;        /* Number of records that follow. */
+	uint64_t timer_freq;        /* Timer ticks per second. */
+	uint64_t start_tsc;         /* TSC and timer ticks when tracing */
+	int64_t start_ticks;        /*   started and when it stopped, */
+	uint64_t end_tsc;           /*   for converting TSC values */
+	int64_t end_ticks;          /*   into time. */
+};
+
+extern bool trace_enabled;
+
+void trace_init (void);
+void trace_init_cpu (int id);
+void trace_record (enum trace_event, uint64_t arg);
+void trace_dump (void);
+
+/* Records EVENT with argument ARG, if tracing is enabled. */
+#define TRACE(EVENT, ARG)                                       \
+	do {                                                    \
+		if (trace_enabled)                              \
+			trace_record ((EVENT), (uint64_t) (ARG)); \
+	} while (0)
+
+#endif /* threads/trace.h */
@@ -0,0 +1,72 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "devices/timer.h"
+#include "threads/synch.h"
+
+/* Workqueues.
+
+   A workqueue runs deferred work items in a pool of kernel
+   threads.  Work can be queued from any context, including
+   interrupt handlers, so an interrupt handler or a caller on a
+   latency-sensitive path can hand off anything that may sleep
+   or take long.
+
+   Each work item has a priority.  Pending items run highest
+   priority first (FIFO among equals), and the worker running an
+   item runs at the item's priority.  The pool starts with one
+   worker and grows, up to the limit given to
+   workqueue_create(), whenever work is pending and every
+   worker is busy.
+
+   A work item may be pending and running at the same time if it
+   is queued again while it runs; it then runs once more.  FUNC
+   must not free its own work item, because the worker still
+   updates it afterward; free it after cancel_work_sync(). */
+
+struct work;
+typedef void work_func (struct work *);
+
+/* A work item.  Embed it in the object the work is about and
+   use list_entry()-style pointer arithmetic in FUNC to get back
+   to that object. */
+struct work {
+	work_func *func;            /* Function to run. */
+	int priority;               /* Priority to run FUNC at. */
+	struct workqueue *wq;       /* Queue last queued on. */
+	bool pending;               /* In wq->pending? */
+	bool running;               /* FUNC being run by a worker? */
+	struct list_elem elem;      /* wq->pending element. */
+	struct timer_event timer;   /* For queue_delayed_work(). */
+};
+
+/* A workqueue. */
+struct workqueue {
+	char name[8];               /* Name, for the worker threads. */
+	struct list pending;        /* Pending work, by priority. */
+	struct semaphore avail;     /* Up once per queued item. */
+	struct list flushers;       /* Threads blocked in a flush. */
+	size_t nr_workers;          /* Worker threads. */
+	size_t nr_busy;             /* Workers running an item. */
+	size_t max_workers;         /* Limit on nr_workers. */
+};
+
+/* Default workqueue, created by workqueue_init(). */
+extern struct workqueue *system_wq;
+
+void workqueue_init (void);
+struct workqueue *workqueue_create (const char *name, size_t max_workers);
+
+void work_init (struct work *, work_func *, int priority);
+bool queue_work (struct workqueue *, struct work *);
+bool queue_delayed_work (struct workqueue *, struct work *, int64_t ticks);
+bool cancel_work (struct work *);
+bool cancel_work_sync (struct work *);
+void flush_work (struct work *);
+void flush_workqueue (struct workqueue *);
+
+#endif /* threads/workqueue.h */
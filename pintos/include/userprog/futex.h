@@ -0,0 +1,14 @@
+#ifndef USERPROG_FUTEX_H
+#define USERPROG_FUTEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct process;
+
+void futex_init (void);
+int futex_wait (const int *uaddr, int expected);
+int futex_wake (const int *uaddr, int n);
+void futex_wake_process (struct process *proc);
+
+#endif /* userprog/futex.h */
@@ -2,11 +2,19 @@
 #define USERPROG_PROCESS_H
 
 #include "threads/thread.h"
+#include "threads/vaddr.h"
 #include <hash.h>
 
 #define FD_NEXT 2
 #define FD_LIMIT 64
 
+/* Extra user threads of a process get their stacks in fixed
+   slots below the initial thread's stack, THREAD_STACK_GAP bytes
+   apart, leaving the top megabyte to the initial stack. */
+#define THREAD_STACK_SLOTS 32
+#define THREAD_STACK_GAP (16 * PGSIZE)
+#define THREAD_STACK_TOP (USER_STACK - (1 << 20))
+
 /* 파일 디스크립터의 타입을 저장하기 위한 enum */
 enum fd_type { FD_NONE, FD_STDIN, FD_STDOUT, FD_FILE };
 
@@ -14,8 +22,41 @@ enum fd_type { FD_NONE, FD_STDIN, FD_STDOUT, FD_FILE };
 struct fd_node {
 	enum fd_type type;
 	struct file *file;
+	int refcnt;                 /* fd_table 슬롯 + 사용 중인 스레드 수, fd_lock이 보호 */
+};
+
+/* A user process: the state shared by all of its threads.
+
+   The thread that loaded the program (MAIN) reports the exit
+   status to the parent's wait().  Further threads made with the
+   thread_create system call share the address space, the
+   supplemental page table and the open files, and are counted in
+   REFCNT; the last thread to leave tears the shared state down.
+
+   When any thread calls exit(), EXIT_CALLED and EXITING are set
+   and the other threads exit the next time they would return to
+   user mode.  exec() sets only EXITING while it clears out the
+   other threads, and clears it again unless one of them called
+   exit() in the meantime. */
+struct process {
+	int refcnt;                         /* Threads in this process. */
+	struct thread *main;                /* Initial thread, null once it exits. */
+	struct fd_table fd_table;           /* Open files. */
+	struct file *current_file;          /* Running executable. */
+#ifdef VM
+	struct supplemental_page_table spt; /* Whole virtual memory. */
+#endif
+	struct list threads;                /* struct child_state of extra threads. */
+	uint32_t stack_slots;               /* Stack slots in use, one bit each. */
+	struct lock fd_lock;                /* Guards FD_TABLE slot changes. */
+	bool exiting;                       /* Other threads must exit. */
+	bool exit_called;                   /* Set by exit(). */
+	int exit_status;                    /* Status passed to exit(). */
+	struct semaphore alone;             /* Upped when REFCNT drops to 1. */
+	struct rusage ru;                   /* CPU usage of exited threads. */
 };
 
+void process_cache_init (void);
 int process_file_open (const char *file_name);
 int process_file_length (int fd);
 int process_file_read (int fd, void *buffer, unsigned size);
@@ -30,5 +71,11 @@ int process_exec (void *f_name);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (struct thread *next);
+tid_t process_thread_create (void *entry, void *arg0, void *arg1);
+int process_thread_join (tid_t tid);
+void process_thread_exit (int status) NO_RETURN;
+void process_check_exiting (void);
+void process_kill_siblings (struct process *proc);
+int process_getrusage (int who, struct rusage *ru);
 
 #endif /* userprog/process.h */
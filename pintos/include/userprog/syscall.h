@@ -2,9 +2,12 @@
 #define USERPROG_SYSCALL_H
 
 #include <stdbool.h>
+#include <lockstat.h>
+#include <rusage.h>
 #include "threads/thread.h"
 
 void syscall_init (void);
+void syscall_init_cpu (void);
 
 void check_address (void *addr);
 void sys_halt (void);
@@ -21,5 +24,13 @@ int sys_write (int fd, const void *buffer, unsigned size);
 void sys_seek (int fd, unsigned position);
 unsigned sys_tell (int fd);
 void sys_close(int fd);
+int sys_lockstat (struct lockstat *buf, int cnt);
+int sys_getrusage (int who, struct rusage *ru);
+int sys_sched_setscheduler (int policy, int rt_priority);
+int sys_futex_wait (const int *uaddr, int expected);
+int sys_futex_wake (const int *uaddr, int n);
+tid_t sys_thread_create (void *entry, void *function, void *aux);
+int sys_thread_join (tid_t tid);
+void sys_thread_exit (int status) NO_RETURN;
 
 #endif /* userprog/syscall.h */
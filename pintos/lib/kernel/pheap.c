@@ -0,0 +1,211 @@
+#include "pheap.h"
+#include "../debug.h"
+
+/* A pairing heap is a heap-ordered multiway tree.  Each node
+   keeps a pointer to its leftmost child, and the children of a
+   node form a doubly linked sibling list whose leftmost `prev'
+   pointer points back to the parent.  That back pointer is what
+   lets us cut an arbitrary element out of the tree in O(1).
+
+   Two trees are combined ("melded") by making the root with the
+   smaller key the leftmost child of the other.  Removing the
+   root leaves a list of subtrees, which are melded in pairs from
+   left to right and then melded together from right to left.
+   This "two-pass" merge gives the amortized O(log n) bound. */
+
+static struct pheap_elem *meld (struct pheap *,
+		struct pheap_elem *, struct pheap_elem *);
+static struct pheap_elem *merge_pairs (struct pheap *, struct pheap_elem *);
+static void cut (struct pheap_elem *);
+static struct pheap_elem *parent (struct pheap_elem *);
+
+/* Initializes HEAP as an empty heap ordered by LESS given
+   auxiliary data AUX. */
+void
+pheap_init (struct pheap *heap, pheap_less_func *less, void *aux) {
+	ASSERT (heap != NULL);
+	ASSERT (less != NULL);
+
+	heap->root = NULL;
+	heap->size = 0;
+	heap->less = less;
+	heap->aux = aux;
+}
+
+/* Returns true if HEAP is empty, false otherwise. */
+bool
+pheap_empty (const struct pheap *heap) {
+	return heap->root == NULL;
+}
+
+/* Returns the number of elements in HEAP. */
+size_t
+pheap_size (const struct pheap *heap) {
+	return heap->size;
+}
+
+/* Returns the greatest element in HEAP, or a null pointer if
+   HEAP is empty. */
+struct pheap_elem *
+pheap_top (const struct pheap *heap) {
+	return heap->root;
+}
+
+/* Inserts ELEM into HEAP. */
+void
+pheap_push (struct pheap *heap, struct pheap_elem *elem) {
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+
+	elem->child = elem->next = elem->prev = NULL;
+	heap->root = meld (heap, heap->root, elem);
+	heap->size++;
+}
+
+/* Removes the greatest element from HEAP and returns it.
+   Undefined behavior if HEAP is empty before removal. */
+struct pheap_elem *
+pheap_pop (struct pheap *heap) {
+	struct pheap_elem *top = heap->root;
+
+	ASSERT (top != NULL);
+
+	heap->root = merge_pairs (heap, top->child);
+	heap->size--;
+	top->child = NULL;
+	return top;
+}
+
+/* Removes ELEM, which must be in HEAP, from HEAP. */
+void
+pheap_remove (struct pheap *heap, struct pheap_elem *elem) {
+	struct pheap_elem *sub;
+
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+
+	if (elem == heap->root) {
+		pheap_pop (heap);
+		return;
+	}
+
+	cut (elem);
+	sub = merge_pairs (heap, elem->child);
+	elem->child = NULL;
+	heap->root = meld (heap, heap->root, sub);
+	heap->size--;
+}
+
+/* Restores the heap order after the key of ELEM, which is in
+   HEAP, has been increased or decreased. */
+void
+pheap_update (struct pheap *heap, struct pheap_elem *elem) {
+	pheap_remove (heap, elem);
+	pheap_push (heap, elem);
+}
+
+/* Calls ACTION on each element of HEAP, in no particular order,
+   passing along AUX.  ACTION must not change HEAP.  Walks the
+   tree through its own links, so no stack space is needed. */
+void
+pheap_for_each (struct pheap *heap, pheap_action_func *action, void *aux) {
+	struct pheap_elem *e;
+
+	ASSERT (heap != NULL);
+	ASSERT (action != NULL);
+
+	e = heap->root;
+	while (e != NULL) {
+		struct pheap_elem *next = e->child;
+
+		/* Preorder: go down first, otherwise to the next sibling
+		   of the nearest ancestor that has one. */
+		for (struct pheap_elem *up = e; next == NULL && up != NULL; up = parent (up))
+			next = up->next;
+		action (e, aux);
+		e = next;
+	}
+}
+
+/* Melds the trees rooted at A and B, either of which may be
+   null, and returns the root of the result.  A and B must not
+   have siblings. */
+static struct pheap_elem *
+meld (struct pheap *heap, struct pheap_elem *a, struct pheap_elem *b) {
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+
+	if (heap->less (a, b, heap->aux)) {
+		struct pheap_elem *tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	/* B becomes the leftmost child of A. */
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+	return a;
+}
+
+/* Melds the sibling list starting at FIRST into a single tree
+   using the two-pass method and returns its root. */
+static struct pheap_elem *
+merge_pairs (struct pheap *heap, struct pheap_elem *first) {
+	struct pheap_elem *pairs = NULL;
+	struct pheap_elem *root = NULL;
+
+	/* First pass: meld adjacent pairs from left to right, pushing
+	   each result on a stack linked through `next'. */
+	while (first != NULL) {
+		struct pheap_elem *a = first;
+		struct pheap_elem *b = a->next;
+		struct pheap_elem *pair;
+
+		first = b != NULL ? b->next : NULL;
+		a->next = a->prev = NULL;
+		if (b != NULL)
+			b->next = b->prev = NULL;
+		pair = meld (heap, a, b);
+		pair->next = pairs;
+		pairs = pair;
+	}
+
+	/* Second pass: meld the pairs from right to left. */
+	while (pairs != NULL) {
+		struct pheap_elem *pair = pairs;
+
+		pairs = pair->next;
+		pair->next = NULL;
+		root = meld (heap, root, pair);
+	}
+	return root;
+}
+
+/* Cuts ELEM, which must not be a root, out of its sibling list
+   together with its subtree. */
+static void
+cut (struct pheap_elem *elem) {
+	ASSERT (elem->prev != NULL);
+
+	if (elem->prev->child == elem)
+		elem->prev->child = elem->next;
+	else
+		elem->prev->next = elem->next;
+	if (elem->next != NULL)
+		elem->next->prev = elem->prev;
+	elem->next = elem->prev = NULL;
+}
+
+/* Returns the parent of ELEM, or a null pointer if ELEM is a
+   root. */
+static struct pheap_elem *
+parent (struct pheap_elem *elem) {
+	while (elem->prev != NULL && elem->prev->child != elem)
+		elem = elem->prev;
+	return elem->prev;
+}
@@ -0,0 +1,310 @@
+#include "rbtree.h"
+#include "../debug.h"
+
+/* A red-black tree is a binary search tree whose nodes are
+   colored so that
+     1. the root is black,
+     2. a red node has no red child, and
+     3. every path from a node down to a null leaf passes through
+        the same number of black nodes.
+   Together these keep the longest path at most twice as long as
+   the shortest, so the height is O(log n).  Null leaves count as
+   black.  The algorithms are the ones in CLRS, chapter 13, with
+   the sentinel replaced by null checks. */
+
+static void rotate_left (struct rbtree *, struct rb_node *);
+static void rotate_right (struct rbtree *, struct rb_node *);
+static void transplant (struct rbtree *, struct rb_node *, struct rb_node *);
+static void insert_fixup (struct rbtree *, struct rb_node *);
+static void remove_fixup (struct rbtree *, struct rb_node *, struct rb_node *);
+static struct rb_node *leftmost (struct rb_node *);
+static bool is_red (const struct rb_node *);
+
+/* Initializes TREE as an empty tree ordered by LESS given
+   auxiliary data AUX. */
+void
+rb_init (struct rbtree *tree, rb_less_func *less, void *aux) {
+	ASSERT (tree != NULL);
+	ASSERT (less != NULL);
+
+	tree->root = tree->first = NULL;
+	tree->size = 0;
+	tree->less = less;
+	tree->aux = aux;
+}
+
+/* Returns true if TREE is empty, false otherwise. */
+bool
+rb_empty (const struct rbtree *tree) {
+	return tree->root == NULL;
+}
+
+/* Returns the number of nodes in TREE. */
+size_t
+rb_size (const struct rbtree *tree) {
+	return tree->size;
+}
+
+/* Returns the smallest node in TREE, or a null pointer if TREE
+   is empty. */
+struct rb_node *
+rb_first (const struct rbtree *tree) {
+	return tree->first;
+}
+
+/* Returns the node that follows NODE in its tree, or a null
+   pointer if NODE is the greatest. */
+struct rb_node *
+rb_next (const struct rb_node *node) {
+	ASSERT (node != NULL);
+
+	if (node->right != NULL)
+		return leftmost (node->right);
+	while (node->parent != NULL && node == node->parent->right)
+		node = node->parent;
+	return node->parent;
+}
+
+/* Inserts NODE into TREE. */
+void
+rb_insert (struct rbtree *tree, struct rb_node *node) {
+	struct rb_node **link = &tree->root;
+	struct rb_node *parent = NULL;
+	bool is_first = true;
+
+	ASSERT (tree != NULL);
+	ASSERT (node != NULL);
+
+	while (*link != NULL) {
+		parent = *link;
+		if (tree->less (node, parent, tree->aux))
+			link = &parent->left;
+		else {
+			link = &parent->right;
+			is_first = false;
+		}
+	}
+
+	node->parent = parent;
+	node->left = node->right = NULL;
+	node->red = true;
+	*link = node;
+	if (is_first)
+		tree->first = node;
+	tree->size++;
+
+	insert_fixup (tree, node);
+}
+
+/* Removes NODE, which must be in TREE, from TREE. */
+void
+rb_remove (struct rbtree *tree, struct rb_node *node) {
+	struct rb_node *x, *x_parent;
+	bool removed_red = node->red;
+
+	ASSERT (tree != NULL);
+	ASSERT (node != NULL);
+
+	if (tree->first == node)
+		tree->first = rb_next (node);
+
+	if (node->left == NULL) {
+		x = node->right;
+		x_parent = node->parent;
+		transplant (tree, node, node->right);
+	} else if (node->right == NULL) {
+		x = node->left;
+		x_parent = node->parent;
+		transplant (tree, node, node->left);
+	} else {
+		/* Two children: NODE's successor Y, which has no left
+		   child, takes NODE's place and color.  The color that
+		   disappears from the tree is Y's. */
+		struct rb_node *y = leftmost (node->right);
+
+		removed_red = y->red;
+		x = y->right;
+		if (y->parent == node)
+			x_parent = y;
+		else {
+			x_parent = y->parent;
+			transplant (tree, y, y->right);
+			y->right = node->right;
+			y->right->parent = y;
+		}
+		transplant (tree, node, y);
+		y->left = node->left;
+		y->left->parent = y;
+		y->red = node->red;
+	}
+	tree->size--;
+
+	if (!removed_red)
+		remove_fixup (tree, x, x_parent);
+}
+
+/* Restores property 2 after inserting red NODE. */
+static void
+insert_fixup (struct rbtree *tree, struct rb_node *node) {
+	while (is_red (node->parent)) {
+		struct rb_node *parent = node->parent;
+		struct rb_node *grand = parent->parent;   /* Red is never root. */
+
+		if (parent == grand->left) {
+			struct rb_node *uncle = grand->right;
+
+			if (is_red (uncle)) {
+				parent->red = uncle->red = false;
+				grand->red = true;
+				node = grand;
+				continue;
+			}
+			if (node == parent->right) {
+				rotate_left (tree, parent);
+				node = parent;
+				parent = node->parent;
+			}
+			parent->red = false;
+			grand->red = true;
+			rotate_right (tree, grand);
+		} else {
+			struct rb_node *uncle = grand->left;
+
+			if (is_red (uncle)) {
+				parent->red = uncle->red = false;
+				grand->red = true;
+				node = grand;
+				continue;
+			}
+			if (node == parent->left) {
+				rotate_right (tree, parent);
+				node = parent;
+				parent = node->parent;
+			}
+			parent->red = false;
+			grand->red = true;
+			rotate_left (tree, grand);
+		}
+	}
+	tree->root->red = false;
+}
+
+/* Restores property 3 after a black node was removed from above
+   X, which may be null, so that X's paths are one black short.
+   PARENT is X's parent, needed because X may be null. */
+static void
+remove_fixup (struct rbtree *tree, struct rb_node *x, struct rb_node *parent) {
+	while (x != tree->root && !is_red (x)) {
+		if (x == parent->left) {
+			struct rb_node *w = parent->right;
+
+			if (is_red (w)) {
+				w->red = false;
+				parent->red = true;
+				rotate_left (tree, parent);
+				w = parent->right;
+			}
+			if (!is_red (w->left) && !is_red (w->right)) {
+				w->red = true;
+				x = parent;
+				parent = x->parent;
+			} else {
+				if (!is_red (w->right)) {
+					w->left->red = false;
+					w->red = true;
+					rotate_right (tree, w);
+					w = parent->right;
+				}
+				w->red = parent->red;
+				parent->red = false;
+				w->right->red = false;
+				rotate_left (tree, parent);
+				x = tree->root;
+			}
+		} else {
+			struct rb_node *w = parent->left;
+
+			if (is_red (w)) {
+				w->red = false;
+				parent->red = true;
+				rotate_right (tree, parent);
+				w = parent->left;
+			}
+			if (!is_red (w->left) && !is_red (w->right)) {
+				w->red = true;
+				x = parent;
+				parent = x->parent;
+			} else {
+				if (!is_red (w->left)) {
+					w->right->red = false;
+					w->red = true;
+					rotate_left (tree, w);
+					w = parent->left;
+				}
+				w->red = parent->red;
+				parent->red = false;
+				w->left->red = false;
+				rotate_right (tree, parent);
+				x = tree->root;
+			}
+		}
+	}
+	if (x != NULL)
+		x->red = false;
+}
+
+/* Makes X's right child take X's place, with X as its left
+   child. */
+static void
+rotate_left (struct rbtree *tree, struct rb_node *x) {
+	struct rb_node *y = x->right;
+
+	x->right = y->left;
+	if (y->left != NULL)
+		y->left->parent = x;
+	transplant (tree, x, y);
+	y->left = x;
+	x->parent = y;
+}
+
+/* Makes X's left child take X's place, with X as its right
+   child. */
+static void
+rotate_right (struct rbtree *tree, struct rb_node *x) {
+	struct rb_node *y = x->left;
+
+	x->left = y->right;
+	if (y->right != NULL)
+		y->right->parent = x;
+	transplant (tree, x, y);
+	y->right = x;
+	x->parent = y;
+}
+
+/* Replaces the subtree rooted at U by the one rooted at V, which
+   may be null, in U's parent. */
+static void
+transplant (struct rbtree *tree, struct rb_node *u, struct rb_node *v) {
+	if (u->parent == NULL)
+		tree->root = v;
+	else if (u == u->parent->left)
+		u->parent->left = v;
+	else
+		u->parent->right = v;
+	if (v != NULL)
+		v->parent = u->parent;
+}
+
+/* Returns the smallest node in the subtree rooted at NODE. */
+static struct rb_node *
+leftmost (struct rb_node *node) {
+	while (node->left != NULL)
+		node = node->left;
+	return node;
+}
+
+/* Null leaves are black. */
+static bool
+is_red (const struct rb_node *node) {
+	return node != NULL && node->red;
+}
@@ -0,0 +1,83 @@
+#include <synch.h>
+#include <limits.h>
+#include <syscall.h>
+
+/* The mutex follows "Futexes Are Tricky" by Ulrich Drepper: the
+   state is 0 when unlocked, 1 when locked with no waiters, and 2
+   when locked and some thread may be sleeping on it.  Only
+   unlocking from state 2 needs futex_wake(). */
+
+/* Initializes mutex M as unlocked. */
+void
+mutex_init (struct mutex *m) {
+	m->state = 0;
+}
+
+/* Acquires mutex M, sleeping until it becomes available. */
+void
+mutex_lock (struct mutex *m) {
+	int c = __sync_val_compare_and_swap (&m->state, 0, 1);
+
+	if (c == 0)
+		return;
+
+	/* Contended: mark that there may be waiters and sleep until
+	   we are the one that changes it from 0. */
+	if (c != 2)
+		c = __sync_lock_test_and_set (&m->state, 2);
+	while (c != 0) {
+		futex_wait ((const int *) &m->state, 2);
+		c = __sync_lock_test_and_set (&m->state, 2);
+	}
+}
+
+/* Acquires mutex M if it is unlocked and returns true, or
+   returns false at once otherwise. */
+bool
+mutex_trylock (struct mutex *m) {
+	return __sync_bool_compare_and_swap (&m->state, 0, 1);
+}
+
+/* Releases mutex M, which the caller must hold. */
+void
+mutex_unlock (struct mutex *m) {
+	if (__sync_fetch_and_sub (&m->state, 1) != 1) {
+		m->state = 0;
+		futex_wake ((const int *) &m->state, 1);
+	}
+}
+
+/* Initializes condition variable CV. */
+void
+condvar_init (struct condvar *cv) {
+	cv->seq = 0;
+}
+
+/* Atomically releases M and waits for CV to be signaled, then
+   reacquires M.  M must be held.  As with the kernel's condition
+   variables, wakeups may be spurious, so the caller must recheck
+   its condition. */
+void
+condvar_wait (struct condvar *cv, struct mutex *m) {
+	int seq = cv->seq;
+
+	mutex_unlock (m);
+	/* A signal between the unlock and the wait changes SEQ, so
+	   futex_wait() returns at once instead of missing it. */
+	futex_wait ((const int *) &cv->seq, seq);
+	mutex_lock (m);
+}
+
+/* Wakes one thread waiting on CV, if any. */
+void
+condvar_signal (struct condvar *cv) {
+	__sync_fetch_and_add (&cv->seq, 1);
+	futex_wake ((const int *) &cv->seq, 1);
+}
+
+/* Wakes all threads waiting on CV. */
+void
+condvar_broadcast (struct condvar *cv) {
+	__sync_fetch_and_add (&cv->seq, 1);
+	futex_wake ((const int *) &cv->seq, INT_MAX);
+}
@@ -194,3 +194,52 @@ int
 umount (const char *path) {
 	return syscall1 (SYS_UMOUNT, path);
 }
+
+int
+lockstat (struct lockstat *buf, int cnt) {
+	return syscall2 (SYS_LOCKSTAT, buf, cnt);
+}
+
+int
+getrusage (int who, struct rusage *ru) {
+	return syscall2 (SYS_GETRUSAGE, who, ru);
+}
+
+int
+sched_setscheduler (int policy, int rt_priority) {
+	return syscall2 (SYS_SCHED_SETSCHEDULER, policy, rt_priority);
+}
+
+int
+futex_wait (const int *addr, int expected) {
+	return syscall2 (SYS_FUTEX_WAIT, addr, expected);
+}
+
+int
+futex_wake (const int *addr, int n) {
+	return syscall2 (SYS_FUTEX_WAKE, addr, n);
+}
+
+/* Where every thread made by thread_create() starts: runs
+   FUNCTION and ends the thread with status 0 if it returns. */
+static void
+thread_entry (thread_func *function, void *aux) {
+	function (aux);
+	thread_exit (0);
+}
+
+tid_t
+thread_create (thread_func *function, void *aux) {
+	return (tid_t) syscall3 (SYS_THREAD_CREATE, thread_entry, function, aux);
+}
+
+int
+thread_join (tid_t tid) {
+	return syscall1 (SYS_THREAD_JOIN, tid);
+}
+
+void
+thread_exit (int status) {
+	syscall1 (SYS_THREAD_EXIT, status);
+	NOT_REACHED ();
+}
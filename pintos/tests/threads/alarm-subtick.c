@@ -0,0 +1,67 @@
+/* Sleeps for half a timer tick, many times over.  Each sleep
+   must last at least as long as asked, the whole run must take
+   far less than one tick per sleep, and a lower-priority thread
+   must get the CPU in between, which shows that the sleeps block
+   rather than busy-wait. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+#define SLEEP_CNT 20
+#define SLEEP_US (1000 * 1000 / TIMER_FREQ / 2)
+
+static thread_func counter_thread_func;
+
+static volatile bool stop;
+static volatile long long count;
+static struct semaphore done;
+
+void
+test_alarm_subtick (void) 
+{
+  int64_t start;
+  int too_short = 0;
+  long long seen;
+
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+  thread_create ("counter", PRI_DEFAULT - 1, counter_thread_func, NULL);
+
+  start = timer_ticks ();
+  for (int i = 0; i < SLEEP_CNT; i++) 
+    {
+      uint64_t t0 = rdtsc ();
+      timer_usleep (SLEEP_US);
+      if (timer_tsc_to_ns (rdtsc () - t0) < SLEEP_US * 1000ULL)
+        too_short++;
+    }
+  seen = count;
+  stop = true;
+
+  if (too_short > 0)
+    fail ("%d of %d sleeps returned early.", too_short, SLEEP_CNT);
+  msg ("No sleep returned early.");
+  if (timer_elapsed (start) >= SLEEP_CNT / 2)
+    fail ("%d half-tick sleeps took %lld ticks.",
+          SLEEP_CNT, timer_elapsed (start));
+  msg ("Sleeps were not rounded up to whole ticks.");
+  if (seen == 0)
+    fail ("Lower-priority thread never ran during the sleeps.");
+  msg ("Lower-priority thread ran during the sleeps.");
+
+  sema_down (&done);
+}
+
+static void
+counter_thread_func (void *aux UNUSED) 
+{
+  while (!stop)
+    count++;
+  sema_up (&done);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-subtick) begin
+(alarm-subtick) No sleep returned early.
+(alarm-subtick) Sleeps were not rounded up to whole ticks.
+(alarm-subtick) Lower-priority thread ran during the sleeps.
+(alarm-subtick) end
+EOF
+pass;
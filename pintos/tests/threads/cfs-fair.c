@@ -0,0 +1,89 @@
+/* Runs three CPU-bound threads under the completely fair
+   scheduler, two at nice 0 and one at nice 5, and counts the
+   ticks each one observes while it runs.
+
+   The two nice 0 threads should get about the same share.  With
+   weights 1024 and 335, each of them should get about 3 times as
+   much CPU as the nice 5 thread. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 3
+#define SPIN_SECONDS 10
+
+struct thread_info 
+  {
+    int64_t start_time;
+    int tick_count;
+    int nice;
+  };
+
+static thread_func load_thread;
+static struct semaphore done;
+
+void
+test_cfs_fair (void) 
+{
+  static const int nices[THREAD_CNT] = {0, 0, 5};
+  struct thread_info info[THREAD_CNT];
+  int64_t start_time;
+  int a, b, c;
+
+  ASSERT (thread_cfs);
+
+  sema_init (&done, 0);
+  start_time = timer_ticks ();
+  for (int i = 0; i < THREAD_CNT; i++) 
+    {
+      char name[16];
+
+      info[i].start_time = start_time;
+      info[i].tick_count = 0;
+      info[i].nice = nices[i];
+      snprintf (name, sizeof name, "load %d", i);
+      thread_create (name, PRI_DEFAULT, load_thread, &info[i]);
+    }
+  msg ("Running %d threads for %d seconds, please wait...",
+       THREAD_CNT, SPIN_SECONDS);
+  for (int i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+
+  a = info[0].tick_count;
+  b = info[1].tick_count;
+  c = info[2].tick_count;
+  if (a + b + c < SPIN_SECONDS * TIMER_FREQ * 9 / 10)
+    fail ("Threads received only %d ticks in all.", a + b + c);
+  if ((a > b ? a - b : b - a) * 10 > (a + b) / 2)
+    fail ("Nice 0 threads received %d and %d ticks.", a, b);
+  msg ("Nice 0 threads received about the same share.");
+  if (c * 2 > (a + b) / 2 || c * 5 < (a + b) / 2)
+    fail ("Nice 0 threads received %d and %d ticks, nice 5 thread %d.",
+          a, b, c);
+  msg ("Nice 5 thread received about a third as much.");
+}
+
+static void
+load_thread (void *ti_) 
+{
+  struct thread_info *ti = ti_;
+  int64_t sleep_time = TIMER_FREQ;
+  int64_t spin_time = sleep_time + SPIN_SECONDS * TIMER_FREQ;
+  int64_t last_time = 0;
+
+  thread_set_nice (ti->nice);
+  timer_sleep (sleep_time - timer_elapsed (ti->start_time));
+  while (timer_elapsed (ti->start_time) < spin_time) 
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        ti->tick_count++;
+      last_time = cur_time;
+    }
+  sema_up (&done);
+}
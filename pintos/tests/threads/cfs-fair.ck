@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(cfs-fair) begin
+(cfs-fair) Running 3 threads for 10 seconds, please wait...
+(cfs-fair) Nice 0 threads received about the same share.
+(cfs-fair) Nice 5 thread received about a third as much.
+(cfs-fair) end
+EOF
+pass;
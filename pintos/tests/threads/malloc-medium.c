@@ -0,0 +1,111 @@
+/* Exercises the medium size classes of malloc(), between 1 kB
+   and 64 kB, which come from multi-page arenas, and realloc()
+   of blocks as they move between small, medium and big. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+
+#define BLOCK_CNT 8
+
+static void fill (void *, size_t size, int seed);
+static bool check (const void *, size_t size, int seed);
+
+void
+test_malloc_medium (void) 
+{
+  static const size_t sizes[] = {1100, 1536, 2000, 3072, 4096, 6000,
+                                 12000, 40000, 65536};
+  static const size_t steps[] = {100, 1500, 3000, 10000, 70000,
+                                 200000, 2000, 10};
+  void *blocks[BLOCK_CNT];
+  size_t size, old_size;
+  void *p, *q;
+
+  /* Blocks of one size class must not overlap. */
+  for (size_t i = 0; i < sizeof sizes / sizeof *sizes; i++) 
+    {
+      size = sizes[i];
+      for (int j = 0; j < BLOCK_CNT; j++) 
+        {
+          blocks[j] = malloc (size);
+          if (blocks[j] == NULL)
+            fail ("malloc (%zu) failed.", size);
+          fill (blocks[j], size, j);
+        }
+      for (int j = 0; j < BLOCK_CNT; j++) 
+        {
+          if (!check (blocks[j], size, j))
+            fail ("%zu-byte block %d was overwritten.", size, j);
+          free (blocks[j]);
+        }
+    }
+  msg ("Medium blocks do not overlap.");
+
+  /* realloc() within a size class keeps the block. */
+  p = malloc (1100);
+  if (p == NULL || realloc (p, 1500) != p)
+    fail ("realloc within the 1.5 kB class moved the block.");
+  free (p);
+  msg ("realloc within a size class stays in place.");
+
+  /* Grow a block from small through medium to big and back,
+     checking that its contents come along each time. */
+  old_size = 16;
+  p = malloc (old_size);
+  if (p == NULL)
+    fail ("malloc (16) failed.");
+  fill (p, old_size, 0);
+  for (size_t i = 0; i < sizeof steps / sizeof *steps; i++) 
+    {
+      size = steps[i];
+      q = realloc (p, size);
+      if (q == NULL)
+        fail ("realloc to %zu bytes failed.", size);
+      if (!check (q, size < old_size ? size : old_size, 0))
+        fail ("realloc from %zu to %zu bytes lost data.", old_size, size);
+      fill (q, size, 0);
+      p = q;
+      old_size = size;
+    }
+  free (p);
+  msg ("realloc keeps contents across small, medium and big.");
+
+  /* Arenas are given back and reused. */
+  for (int round = 0; round < 16; round++) 
+    {
+      for (int j = 0; j < BLOCK_CNT; j++) 
+        {
+          blocks[j] = malloc (40000);
+          if (blocks[j] == NULL)
+            fail ("malloc (40000) failed in round %d.", round);
+        }
+      for (int j = 0; j < BLOCK_CNT; j++)
+        free (blocks[j]);
+    }
+  msg ("Medium arenas are reused.");
+}
+
+/* Fills SIZE bytes at P with a pattern derived from SEED. */
+static void
+fill (void *p_, size_t size, int seed) 
+{
+  uint8_t *p = p_;
+
+  for (size_t i = 0; i < size; i++)
+    p[i] = (uint8_t) (i * 7 + seed);
+}
+
+/* Returns true if SIZE bytes at P still hold the pattern for
+   SEED. */
+static bool
+check (const void *p_, size_t size, int seed) 
+{
+  const uint8_t *p = p_;
+
+  for (size_t i = 0; i < size; i++)
+    if (p[i] != (uint8_t) (i * 7 + seed))
+      return false;
+  return true;
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(malloc-medium) begin
+(malloc-medium) Medium blocks do not overlap.
+(malloc-medium) realloc within a size class stays in place.
+(malloc-medium) realloc keeps contents across small, medium and big.
+(malloc-medium) Medium arenas are reused.
+(malloc-medium) end
+EOF
+pass;
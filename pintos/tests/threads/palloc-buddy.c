@@ -0,0 +1,115 @@
+/* Exercises block splitting and buddy merging in the page
+   allocator through the user pool, which nothing else uses in
+   this kernel.
+
+   Taking the whole pool one page at a time splits every free
+   block down to single pages.  Freeing every other page first
+   leaves no two free buddies next to each other, so the pool
+   only comes back whole if the second half of the frees merge
+   all the way up again.  A 3-page request must give back the
+   fourth page of the 4-page block it is cut from. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+
+static size_t take_all (void **list);
+static void free_all (void *list);
+static size_t largest_block (void);
+
+void
+test_palloc_buddy (void) 
+{
+  size_t page_cnt, block_cnt;
+  void *list, *triple;
+
+  page_cnt = take_all (&list);
+  if (page_cnt < 16)
+    fail ("user pool has only %zu pages.", page_cnt);
+  free_all (list);
+  block_cnt = largest_block ();
+
+  if (take_all (&list) != page_cnt)
+    fail ("pool did not merge back after freeing single pages.");
+  free_all (list);
+  msg ("Single pages merged back into the whole pool.");
+
+  if (largest_block () != block_cnt)
+    fail ("largest free block shrank from %zu pages.", block_cnt);
+  msg ("Largest free block is unchanged.");
+
+  triple = palloc_get_multiple (PAL_USER, 3);
+  if (triple == NULL)
+    fail ("3-page allocation failed.");
+  if (take_all (&list) != page_cnt - 3)
+    fail ("3-page allocation did not give back its tail.");
+  free_all (list);
+  palloc_free_multiple (triple, 3);
+  msg ("3-page allocation took exactly 3 pages.");
+
+  if (take_all (&list) != page_cnt)
+    fail ("pool did not merge back after the 3-page block.");
+  free_all (list);
+  msg ("Pool is whole again.");
+}
+
+/* Allocates user pages one at a time until the pool is empty,
+   chaining them through their first word into *LIST.  Returns
+   the number of pages taken. */
+static size_t
+take_all (void **list) 
+{
+  size_t cnt = 0;
+  void *page;
+
+  *list = NULL;
+  while ((page = palloc_get_page (PAL_USER)) != NULL) 
+    {
+      *(void **) page = *list;
+      *list = page;
+      cnt++;
+    }
+  return cnt;
+}
+
+/* Frees the pages chained from LIST: every other page first,
+   then the rest. */
+static void
+free_all (void *list) 
+{
+  void **prev = &list;
+  void *page;
+
+  /* Unlink and free the 1st, 3rd, 5th, ... page. */
+  while ((page = *prev) != NULL) 
+    {
+      *prev = *(void **) page;
+      palloc_free_page (page);
+      if (*prev == NULL)
+        break;
+      prev = (void **) *prev;
+    }
+
+  while (list != NULL) 
+    {
+      page = list;
+      list = *(void **) page;
+      palloc_free_page (page);
+    }
+}
+
+/* Returns the size in pages of the largest power-of-2 block that
+   can be allocated from the user pool. */
+static size_t
+largest_block (void) 
+{
+  size_t cnt;
+
+  for (cnt = 1; ; cnt *= 2) 
+    {
+      void *block = palloc_get_multiple (PAL_USER, cnt * 2);
+      if (block == NULL)
+        return cnt;
+      palloc_free_multiple (block, cnt * 2);
+    }
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-buddy) begin
+(palloc-buddy) Single pages merged back into the whole pool.
+(palloc-buddy) Largest free block is unchanged.
+(palloc-buddy) 3-page allocation took exactly 3 pages.
+(palloc-buddy) Pool is whole again.
+(palloc-buddy) end
+EOF
+pass;
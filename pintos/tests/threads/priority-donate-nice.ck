@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-donate-nice) begin
+(priority-donate-nice) This thread should have priority 36.  Actual priority: 36.
+(priority-donate-nice) After setting nice, priority should still be 36.  Actual priority: 36.
+(priority-donate-nice) acquire: got the lock
+(priority-donate-nice) acquire: done
+(priority-donate-nice) acquire must already have finished.
+(priority-donate-nice) This thread should have priority 31.  Actual priority: 31.
+(priority-donate-nice) Nice should be 10.  Actual nice: 10.
+(priority-donate-nice) end
+EOF
+pass;
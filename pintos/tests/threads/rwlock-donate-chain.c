@@ -0,0 +1,71 @@
+/* The main thread acquires a lock.  A reader takes a rwlock for
+   reading and then blocks on the main thread's lock, donating
+   its priority.  A writer then blocks on the rwlock, and its
+   priority must reach the main thread through the reader. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct locks 
+  {
+    struct lock lock;
+    struct rwlock rwlock;
+  };
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_rwlock_donate_chain (void) 
+{
+  struct locks locks;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  lock_init (&locks.lock);
+  rwlock_init (&locks.rwlock);
+  lock_acquire (&locks.lock);
+
+  thread_create ("reader", PRI_DEFAULT + 1, reader_thread_func, &locks);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+  thread_create ("writer", PRI_DEFAULT + 9, writer_thread_func, &locks);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 9, thread_get_priority ());
+
+  lock_release (&locks.lock);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+reader_thread_func (void *locks_) 
+{
+  struct locks *locks = locks_;
+
+  rwlock_read_acquire (&locks->rwlock);
+  msg ("reader: got the rwlock");
+  lock_acquire (&locks->lock);
+  msg ("reader: got the lock");
+  lock_release (&locks->lock);
+  rwlock_read_release (&locks->rwlock);
+  msg ("reader: done");
+}
+
+static void
+writer_thread_func (void *locks_) 
+{
+  struct locks *locks = locks_;
+
+  rwlock_write_acquire (&locks->rwlock);
+  msg ("writer: got the rwlock");
+  rwlock_write_release (&locks->rwlock);
+  msg ("writer: done");
+}
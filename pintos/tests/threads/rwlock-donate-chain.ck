@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-donate-chain) begin
+(rwlock-donate-chain) reader: got the rwlock
+(rwlock-donate-chain) Main thread should have priority 32.  Actual priority: 32.
+(rwlock-donate-chain) Main thread should have priority 40.  Actual priority: 40.
+(rwlock-donate-chain) reader: got the lock
+(rwlock-donate-chain) writer: got the rwlock
+(rwlock-donate-chain) writer: done
+(rwlock-donate-chain) reader: done
+(rwlock-donate-chain) Main thread should have priority 31.  Actual priority: 31.
+(rwlock-donate-chain) end
+EOF
+pass;
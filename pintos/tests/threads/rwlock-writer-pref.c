@@ -0,0 +1,60 @@
+/* The main thread holds a rwlock for reading.  A second reader
+   gets it at once, but once a writer waits, later readers wait
+   behind the writer even if their priority is higher.  Both
+   waiters donate their priority to the main thread. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_rwlock_writer_pref (void) 
+{
+  struct rwlock rwlock;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rwlock);
+  rwlock_read_acquire (&rwlock);
+  msg ("main: got the rwlock for reading");
+
+  thread_create ("reader1", PRI_DEFAULT + 1, reader_thread_func, &rwlock);
+  thread_create ("writer", PRI_DEFAULT + 3, writer_thread_func, &rwlock);
+  thread_create ("reader2", PRI_DEFAULT + 4, reader_thread_func, &rwlock);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 4, thread_get_priority ());
+
+  rwlock_read_release (&rwlock);
+  msg ("main: done");
+}
+
+static void
+reader_thread_func (void *rwlock_) 
+{
+  struct rwlock *rwlock = rwlock_;
+
+  rwlock_read_acquire (rwlock);
+  msg ("%s: got the rwlock", thread_name ());
+  rwlock_read_release (rwlock);
+  msg ("%s: done", thread_name ());
+}
+
+static void
+writer_thread_func (void *rwlock_) 
+{
+  struct rwlock *rwlock = rwlock_;
+
+  rwlock_write_acquire (rwlock);
+  msg ("writer: got the rwlock");
+  rwlock_write_release (rwlock);
+  msg ("writer: done");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-writer-pref) begin
+(rwlock-writer-pref) main: got the rwlock for reading
+(rwlock-writer-pref) reader1: got the rwlock
+(rwlock-writer-pref) reader1: done
+(rwlock-writer-pref) Main thread should have priority 35.  Actual priority: 35.
+(rwlock-writer-pref) writer: got the rwlock
+(rwlock-writer-pref) reader2: got the rwlock
+(rwlock-writer-pref) reader2: done
+(rwlock-writer-pref) writer: done
+(rwlock-writer-pref) main: done
+(rwlock-writer-pref) end
+EOF
+pass;
@@ -0,0 +1,66 @@
+/* A SCHED_FIFO thread spins without ever blocking.  The
+   SCHED_OTHER main thread must still get the CPU once the
+   real-time class has used up its budget for the period, i.e.
+   within about one period and not before the budget has gone. */
+
+#include <sched.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func hog_thread_func;
+
+static volatile bool hog_spinning;
+static volatile bool stop;
+static bool hog_gave_up;
+static struct semaphore done;
+
+void
+test_sched_fifo_budget (void) 
+{
+  int64_t start, waited;
+
+  ASSERT (thread_get_scheduler () == SCHED_OTHER);
+
+  sema_init (&done, 0);
+  thread_create ("fifo-hog", PRI_DEFAULT, hog_thread_func, NULL);
+
+  /* Let the hog take over; it keeps the CPU after our wakeup. */
+  start = timer_ticks ();
+  timer_sleep (1);
+  waited = timer_elapsed (start);
+  stop = true;
+
+  if (!hog_spinning)
+    fail ("main thread ran before the SCHED_FIFO thread started");
+  msg ("SCHED_FIFO thread was spinning.");
+  if (waited < TIMER_FREQ / 2)
+    fail ("SCHED_FIFO thread gave up the CPU after only %lld ticks",
+          waited);
+  if (waited > 2 * TIMER_FREQ)
+    fail ("SCHED_OTHER thread starved for %lld ticks", waited);
+  msg ("SCHED_OTHER thread ran within one period.");
+
+  sema_down (&done);
+  if (hog_gave_up)
+    fail ("SCHED_FIFO thread spun until its own timeout");
+  msg ("SCHED_FIFO thread stopped.");
+}
+
+static void
+hog_thread_func (void *aux UNUSED) 
+{
+  int64_t start = timer_ticks ();
+
+  if (thread_set_scheduler (SCHED_FIFO, SCHED_RT_PRIO_MIN) != 0)
+    fail ("thread_set_scheduler (SCHED_FIFO) failed");
+  hog_spinning = true;
+  while (!stop && timer_elapsed (start) < 4 * TIMER_FREQ)
+    continue;
+  hog_gave_up = !stop;
+  thread_set_scheduler (SCHED_OTHER, 0);
+  sema_up (&done);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sched-fifo-budget) begin
+(sched-fifo-budget) SCHED_FIFO thread was spinning.
+(sched-fifo-budget) SCHED_OTHER thread ran within one period.
+(sched-fifo-budget) SCHED_FIFO thread stopped.
+(sched-fifo-budget) end
+EOF
+pass;
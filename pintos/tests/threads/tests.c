@@ -17,6 +17,7 @@ static const struct test tests[] =
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-subtick", test_alarm_subtick},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -25,6 +26,13 @@ static const struct test tests[] =
     {"priority-donate-sema", test_priority_donate_sema},
     {"priority-donate-lower", test_priority_donate_lower},
     {"priority-donate-chain", test_priority_donate_chain},
+    {"priority-donate-nice", test_priority_donate_nice},
+    {"rwlock-writer-pref", test_rwlock_writer_pref},
+    {"rwlock-donate-chain", test_rwlock_donate_chain},
+    {"sched-fifo-budget", test_sched_fifo_budget},
+    {"cfs-fair", test_cfs_fair},
+    {"palloc-buddy", test_palloc_buddy},
+    {"malloc-medium", test_malloc_medium},
     {"priority-fifo", test_priority_fifo},
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
@@ -0,0 +1,34 @@
+/* Calls exec() while two other threads of the process are still
+   running: one asleep in futex_wait(), one spinning in user
+   mode.  exec() must end both and run the new program. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int word;
+
+static void
+sleeper (void *aux UNUSED) 
+{
+  for (;;)
+    futex_wait (&word, 0);
+}
+
+static void
+spinner (void *aux UNUSED) 
+{
+  for (;;)
+    continue;
+}
+
+void
+test_main (void) 
+{
+  if (thread_create (sleeper, NULL) == TID_ERROR
+      || thread_create (spinner, NULL) == TID_ERROR)
+    fail ("thread_create");
+  msg ("exec with two live threads");
+  exec ("child-simple");
+  fail ("exec returned");
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(exec-siblings) begin
+(exec-siblings) exec with two live threads
+(child-simple) run
+exec-siblings: exit(81)
+EOF
+pass;
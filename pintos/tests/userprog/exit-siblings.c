@@ -0,0 +1,34 @@
+/* One thread calls exit() while the initial thread is joining a
+   thread that sleeps in futex_wait() forever.  The sleeper must
+   be woken and ended so that the process exits with the status
+   passed to exit(). */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int word;
+
+static void
+sleeper (void *aux UNUSED) 
+{
+  for (;;)
+    futex_wait (&word, 0);
+}
+
+static void
+exiter (void *aux UNUSED) 
+{
+  exit (57);
+}
+
+void
+test_main (void) 
+{
+  tid_t tid = thread_create (sleeper, NULL);
+
+  if (tid == TID_ERROR || thread_create (exiter, NULL) == TID_ERROR)
+    fail ("thread_create");
+  thread_join (tid);
+  fail ("join returned");
+}
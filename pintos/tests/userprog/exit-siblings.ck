@@ -0,0 +1,9 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(exit-siblings) begin
+exit-siblings: exit(57)
+EOF
+pass;
@@ -0,0 +1,76 @@
+/* Two producers and two consumers pass numbers through a small
+   bounded buffer guarded by a mutex and two condition variables.
+   Every number must come out exactly once. */
+
+#include <syscall.h>
+#include <synch.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BUF_SIZE 4
+#define ITEM_CNT 500            /* Per producer. */
+
+static struct mutex mutex = MUTEX_INITIALIZER;
+static struct condvar not_full = CONDVAR_INITIALIZER;
+static struct condvar not_empty = CONDVAR_INITIALIZER;
+static int buf[BUF_SIZE];
+static int head, tail, used;
+static int sums[2];
+
+static void
+producer (void *first_) 
+{
+  int first = (int) (long) first_;
+
+  for (int i = first; i < first + ITEM_CNT; i++) 
+    {
+      mutex_lock (&mutex);
+      while (used == BUF_SIZE)
+        condvar_wait (&not_full, &mutex);
+      buf[head++ % BUF_SIZE] = i;
+      used++;
+      condvar_signal (&not_empty);
+      mutex_unlock (&mutex);
+    }
+}
+
+static void
+consumer (void *idx_) 
+{
+  int idx = (int) (long) idx_;
+
+  for (int i = 0; i < ITEM_CNT; i++) 
+    {
+      mutex_lock (&mutex);
+      while (used == 0)
+        condvar_wait (&not_empty, &mutex);
+      sums[idx] += buf[tail++ % BUF_SIZE];
+      used--;
+      condvar_signal (&not_full);
+      mutex_unlock (&mutex);
+    }
+}
+
+void
+test_main (void) 
+{
+  tid_t tids[4];
+  int expected = 0;
+
+  for (int i = 0; i < 2 * ITEM_CNT; i++)
+    expected += i;
+
+  tids[0] = thread_create (consumer, (void *) 0L);
+  tids[1] = thread_create (consumer, (void *) 1L);
+  tids[2] = thread_create (producer, (void *) 0L);
+  tids[3] = thread_create (producer, (void *) (long) ITEM_CNT);
+  for (int i = 0; i < 4; i++)
+    if (tids[i] == TID_ERROR)
+      fail ("thread_create");
+  for (int i = 0; i < 4; i++)
+    if (thread_join (tids[i]) != 0)
+      fail ("thread_join");
+
+  CHECK (used == 0, "buffer drained");
+  CHECK (sums[0] + sums[1] == expected, "every item consumed once");
+}
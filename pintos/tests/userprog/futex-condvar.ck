@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-condvar) begin
+(futex-condvar) buffer drained
+(futex-condvar) every item consumed once
+(futex-condvar) end
+futex-condvar: exit(0)
+EOF
+pass;
@@ -0,0 +1,53 @@
+/* Several threads add to a shared counter under a futex-based
+   mutex.  The read-modify-write is spread out so that a timer
+   interrupt inside it would lose updates without the mutex. */
+
+#include <syscall.h>
+#include <synch.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define ITER_CNT 2000
+
+static struct mutex mutex = MUTEX_INITIALIZER;
+static volatile int counter;
+
+static void
+adder (void *aux UNUSED) 
+{
+  for (int i = 0; i < ITER_CNT; i++) 
+    {
+      mutex_lock (&mutex);
+      int value = counter;
+      for (volatile int spin = 0; spin < 100; spin++)
+        continue;
+      counter = value + 1;
+      mutex_unlock (&mutex);
+    }
+}
+
+void
+test_main (void) 
+{
+  tid_t tids[THREAD_CNT];
+  int word = 0;
+
+  CHECK (futex_wait (&word, 1) == -1, "futex_wait on changed value");
+  CHECK (futex_wake (&word, 1) == 0, "futex_wake with no waiters");
+  CHECK (futex_wait (NULL, 0) == -1, "futex_wait on bad address");
+
+  for (int i = 0; i < THREAD_CNT; i++) 
+    {
+      tids[i] = thread_create (adder, NULL);
+      if (tids[i] == TID_ERROR)
+        fail ("thread_create");
+    }
+  for (int i = 0; i < THREAD_CNT; i++)
+    if (thread_join (tids[i]) != 0)
+      fail ("thread_join");
+
+  CHECK (counter == THREAD_CNT * ITER_CNT, "counter is %d", THREAD_CNT * ITER_CNT);
+  CHECK (mutex_trylock (&mutex), "mutex free afterwards");
+  mutex_unlock (&mutex);
+}
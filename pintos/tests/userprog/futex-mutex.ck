@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-mutex) begin
+(futex-mutex) futex_wait on changed value
+(futex-mutex) futex_wake with no waiters
+(futex-mutex) futex_wait on bad address
+(futex-mutex) counter is 8000
+(futex-mutex) mutex free afterwards
+(futex-mutex) end
+futex-mutex: exit(0)
+EOF
+pass;
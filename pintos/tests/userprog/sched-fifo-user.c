@@ -0,0 +1,19 @@
+/* A user program may take SCHED_FIFO, but only below the band
+   of real-time priorities kept for kernel threads. */
+
+#include <sched.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  CHECK (sched_setscheduler (SCHED_FIFO, SCHED_RT_PRIO_MAX) == -1,
+         "SCHED_FIFO at SCHED_RT_PRIO_MAX refused");
+  CHECK (sched_setscheduler (SCHED_FIFO, SCHED_RT_PRIO_USER_MAX + 1) == -1,
+         "SCHED_FIFO above SCHED_RT_PRIO_USER_MAX refused");
+  CHECK (sched_setscheduler (SCHED_FIFO, SCHED_RT_PRIO_USER_MAX) == 0,
+         "SCHED_FIFO at SCHED_RT_PRIO_USER_MAX");
+  CHECK (sched_setscheduler (SCHED_OTHER, 0) == 0, "back to SCHED_OTHER");
+}
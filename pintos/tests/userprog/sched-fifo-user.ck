@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sched-fifo-user) begin
+(sched-fifo-user) SCHED_FIFO at SCHED_RT_PRIO_MAX refused
+(sched-fifo-user) SCHED_FIFO above SCHED_RT_PRIO_USER_MAX refused
+(sched-fifo-user) SCHED_FIFO at SCHED_RT_PRIO_USER_MAX
+(sched-fifo-user) back to SCHED_OTHER
+(sched-fifo-user) end
+sched-fifo-user: exit(0)
+EOF
+pass;
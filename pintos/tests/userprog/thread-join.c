@@ -0,0 +1,48 @@
+/* Creates threads that share the process's memory, then joins
+   each one and checks the status it ended with.  Odd threads
+   call thread_exit(), even ones return from their function. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 6
+
+static volatile int shared[THREAD_CNT];
+
+static void
+worker (void *idx_) 
+{
+  int idx = (int) (long) idx_;
+
+  shared[idx] = idx * 2;
+  if (idx % 2)
+    thread_exit (idx + 10);
+}
+
+void
+test_main (void) 
+{
+  tid_t tids[THREAD_CNT];
+  bool ok = true;
+
+  for (int i = 0; i < THREAD_CNT; i++) 
+    {
+      tids[i] = thread_create (worker, (void *) (long) i);
+      if (tids[i] == TID_ERROR)
+        fail ("thread_create");
+    }
+  for (int i = 0; i < THREAD_CNT; i++)
+    if (thread_join (tids[i]) != (i % 2 ? i + 10 : 0))
+      ok = false;
+  CHECK (ok, "join returns each thread's status");
+
+  ok = true;
+  for (int i = 0; i < THREAD_CNT; i++)
+    if (shared[i] != i * 2)
+      ok = false;
+  CHECK (ok, "writes by threads are visible");
+
+  CHECK (thread_join (tids[0]) == -1, "second join fails");
+  CHECK (thread_join (tids[THREAD_CNT - 1] + 1000) == -1, "join of unknown tid fails");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(thread-join) begin
+(thread-join) join returns each thread's status
+(thread-join) writes by threads are visible
+(thread-join) second join fails
+(thread-join) join of unknown tid fails
+(thread-join) end
+thread-join: exit(0)
+EOF
+pass;
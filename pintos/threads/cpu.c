@@ -0,0 +1,472 @@
+#include "threads/cpu.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/lapic.h"
+#include "devices/timer.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/trace.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+#ifdef USERPROG
+#include "userprog/gdt.h"
+#include "userprog/syscall.h"
+#include "userprog/tss.h"
+#endif
+
+/* Per-CPU data and application processor startup.
+
+   Scheduling state that used to be global in thread.c (the run
+   queue, the idle thread, the time slice counter and the tick
+   statistics) and the TSS used by tss_update() live in a
+   `struct cpu', one per processor.  Each CPU's GS base points to
+   its own, so this_cpu() is a single load.  User mode has its
+   own GS base, which intr_entry, syscall_entry and do_iret()
+   swap in and out with `swapgs'.
+
+   Most of the kernel still uses intr_disable() as its mutual
+   exclusion primitive, which only excludes the local CPU.  So
+   kernel code runs under a big kernel lock (BKL): a CPU takes it
+   whenever it enters the kernel from user mode or from the idle
+   thread's `hlt', and drops it on the way back out.  The lock
+   belongs to the CPU, not to the thread, so it stays held
+   across a thread switch.  User programs run in parallel on all
+   CPUs, while only one CPU at a time runs in the kernel.  A CPU
+   that holds the lock lets a waiting CPU in at every thread
+   switch and every timer tick, see bkl_handoff(). */
+
+/* Model-specific registers holding the GS base. */
+#define MSR_GS_BASE 0xc0000101          /* Current GS base. */
+#define MSR_KERNEL_GS_BASE 0xc0000102   /* Swapped in by `swapgs'. */
+
+/* How long cpu_start_aps() waits for an application processor
+   to come up, in milliseconds. */
+#define AP_TIMEOUT_MS 1000
+
+_Static_assert (offsetof (struct cpu, self) == CPU_SELF, "CPU_SELF");
+_Static_assert (offsetof (struct cpu, scratch) == CPU_SCRATCH, "CPU_SCRATCH");
+_Static_assert (offsetof (struct cpu, tss) == CPU_TSS, "CPU_TSS");
+
+/* All CPUs.  Only the first CPU_CNT entries are in use. */
+struct cpu cpus[NCPU_MAX];
+int cpu_cnt;
+
+/* Big kernel lock, a ticket lock so that CPUs get it in the
+   order they asked for it. */
+static struct {
+	volatile unsigned next;     /* Next ticket to hand out. */
+	volatile unsigned serving;  /* Ticket that holds the lock. */
+	volatile int owner;         /* ID of the CPU holding it, or -1. */
+} bkl;
+
+/* Intel MultiProcessor Specification 1.4 tables, which the BIOS
+   fills in to describe the CPUs. */
+
+/* MP floating pointer structure. */
+struct mp_fps {
+	char signature[4];          /* "_MP_". */
+	uint32_t config;            /* Physical address of struct mp_config. */
+	uint8_t length;             /* In 16-byte units. */
+	uint8_t revision;
+	uint8_t checksum;           /* All bytes add up to 0. */
+	uint8_t type;               /* Default configuration, or 0. */
+	uint8_t features[4];
+} __attribute__ ((packed));
+
+/* MP configuration table header.  The entries follow it. */
+struct mp_config {
+	char signature[4];          /* "PCMP". */
+	uint16_t length;            /* Including the entries. */
+	uint8_t revision;
+	uint8_t checksum;           /* All bytes add up to 0. */
+	char product[20];
+	uint32_t oem_table;
+	uint16_t oem_length;
+	uint16_t entry_cnt;
+	uint32_t lapic;             /* Physical address of the local APICs. */
+	uint16_t ext_length;
+	uint8_t ext_checksum;
+	uint8_t reserved;
+} __attribute__ ((packed));
+
+/* Processor entry.  The other kinds of entry are 8 bytes long. */
+struct mp_proc {
+	uint8_t type;               /* MP_PROC. */
+	uint8_t lapic_id;
+	uint8_t lapic_version;
+	uint8_t flags;              /* MP_PROC_*. */
+	uint32_t signature;
+	uint32_t features;
+	uint64_t reserved;
+} __attribute__ ((packed));
+
+#define MP_PROC 0               /* Processor entry type. */
+#define MP_PROC_EN 0x01         /* Usable. */
+#define MP_PROC_BP 0x02         /* Bootstrap processor. */
+
+/* Real mode code in mpboot.S, copied to AP_TRAMPOLINE. */
+extern char ap_trampoline[], ap_trampoline_end[];
+
+/* Read by mpboot.S's ap_entry64 in the starting processor. */
+uint64_t ap_cr3;                /* Physical address of base_pml4. */
+uint64_t ap_stack;              /* Top of its idle thread's page. */
+
+/* The CPU being started, or a null pointer after a timeout. */
+static struct cpu *volatile ap_cpu;
+
+void ap_main (void) NO_RETURN;
+static void cpu_setup (struct cpu *, int id);
+static struct mp_config *mp_config (void);
+static bool start_ap (struct cpu *);
+static intr_handler_func resched_interrupt;
+static intr_handler_func tlb_interrupt;
+
+/* Initializes the per-CPU data of the bootstrap processor and
+   gives it the big kernel lock.  Called from thread_init()
+   before any thread is created. */
+void
+cpu_init (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	cpu_setup (&cpus[0], 0);
+	cpu_cnt = 1;
+
+	bkl.next = 1;
+	bkl.serving = 0;
+	bkl.owner = 0;
+}
+
+/* Clears C, makes it CPU number ID, and points the running
+   CPU's GS base at it if it is the bootstrap processor. */
+static void
+cpu_setup (struct cpu *c, int id) {
+	memset (c, 0, sizeof *c);
+	c->self = c;
+	c->id = id;
+	spinlock_init (&c->rq.lock);
+	for (int i = PRI_MIN; i <= PRI_MAX; i++)
+		list_init (&c->rq.queues[i]);
+	list_init (&c->rq.rt_queue);
+
+	if (id == 0) {
+		write_msr (MSR_GS_BASE, (uint64_t) c);
+		write_msr (MSR_KERNEL_GS_BASE, 0);
+	}
+}
+
+/* Finds the other CPUs in the BIOS's MP tables and starts them
+   one at a time.  Each one comes up in ap_main() and turns into
+   its own idle thread.  Without MP tables we stay on one CPU
+   and leave the local APIC alone.  Must be called after
+   timer_calibrate(), with interrupts on. */
+void
+cpu_start_aps (void) {
+	struct mp_config *mpc;
+	uint8_t *entry, *end;
+
+	ASSERT (intr_get_level () == INTR_ON);
+
+	mpc = mp_config ();
+	if (mpc == NULL)
+		return;
+
+	lapic_init (mpc->lapic);
+	cpus[0].lapic_id = lapic_id ();
+	intr_register_ext (LAPIC_RESCHED_VEC, resched_interrupt, "Reschedule IPI");
+	intr_register_ext (LAPIC_TLB_VEC, tlb_interrupt, "TLB Shootdown IPI");
+
+	memcpy (ptov (AP_TRAMPOLINE), ap_trampoline,
+			ap_trampoline_end - ap_trampoline);
+	ap_cr3 = vtop (base_pml4);
+
+	entry = (uint8_t *) (mpc + 1);
+	end = (uint8_t *) mpc + mpc->length;
+	while (entry < end) {
+		struct mp_proc *proc = (struct mp_proc *) entry;
+		struct cpu *c;
+
+		if (proc->type != MP_PROC) {
+			entry += 8;
+			continue;
+		}
+		entry += sizeof *proc;
+		if (!(proc->flags & MP_PROC_EN) || proc->lapic_id == cpus[0].lapic_id)
+			continue;
+		if (cpu_cnt == NCPU_MAX) {
+			printf ("cpu: only %d CPUs supported\n", NCPU_MAX);
+			break;
+		}
+
+		c = &cpus[cpu_cnt];
+		cpu_setup (c, cpu_cnt);
+		c->lapic_id = proc->lapic_id;
+		if (!start_ap (c)) {
+			printf ("cpu: CPU with local APIC %d did not start\n", c->lapic_id);
+			break;
+		}
+	}
+	if (cpu_cnt > 1)
+		printf ("%d CPUs online.\n", cpu_cnt);
+}
+
+/* Returns true if SIZE bytes at physical address PA are mapped
+   at ptov(PA).  BIOS tables may lie beyond the end of RAM. */
+static bool
+phys_mapped (uint64_t pa, size_t size) {
+	uint64_t *first = pml4e_walk (base_pml4, (uint64_t) ptov (pa), 0);
+	uint64_t *last = pml4e_walk (base_pml4, (uint64_t) ptov (pa + size - 1), 0);
+
+	return first != NULL && (*first & PTE_P)
+		&& last != NULL && (*last & PTE_P);
+}
+
+/* Returns the sum of the SIZE bytes at P. */
+static uint8_t
+checksum (const void *p, size_t size) {
+	const uint8_t *bytes = p;
+	uint8_t sum = 0;
+
+	for (size_t i = 0; i < size; i++)
+		sum += bytes[i];
+	return sum;
+}
+
+/* Returns the BIOS's MP configuration table, or a null pointer
+   if there is none.  The BIOS data area, which would point to the
+   extended BIOS data area, lies under the initial thread's page,
+   so only the BIOS ROM at 0xf0000...0xfffff is searched. */
+static struct mp_config *
+mp_config (void) {
+	for (uint64_t pa = 0xf0000; pa < 0x100000; pa += 16) {
+		struct mp_fps *fps = ptov (pa);
+		struct mp_config *mpc;
+
+		if (memcmp (fps->signature, "_MP_", 4)
+				|| checksum (fps, sizeof *fps) != 0)
+			continue;
+
+		/* 기본 구성(type != 0)은 CPU 목록이 없으므로 CPU 하나로 동작한다 */
+		if (fps->config == 0 || !phys_mapped (fps->config, sizeof *mpc))
+			return NULL;
+		mpc = ptov (fps->config);
+		if (memcmp (mpc->signature, "PCMP", 4)
+				|| !phys_mapped (fps->config, mpc->length)
+				|| checksum (mpc, mpc->length) != 0)
+			return NULL;
+		return mpc;
+	}
+	return NULL;
+}
+
+/* Starts application processor C and waits until it runs its
+   idle thread.  Returns false if it did not come up in time. */
+static bool
+start_ap (struct cpu *c) {
+	void *stack = thread_prepare_ap (c);
+
+	if (stack == NULL)
+		return false;
+	if (trace_enabled)
+		trace_init_cpu (c->id);
+
+	ap_stack = (uint64_t) stack;
+	ap_cpu = c;
+	lapic_start_ap (c->lapic_id, AP_TRAMPOLINE);
+
+	/* 기다리는 동안 잠들어서 big kernel lock을 놓아야
+	   AP가 lock을 잡고 cpu_cnt를 올릴 수 있다 */
+	for (int ms = 0; ms < AP_TIMEOUT_MS && cpu_cnt == c->id; ms += 10)
+		timer_msleep (10);
+	if (cpu_cnt == c->id) {
+		ap_cpu = NULL;
+		return false;
+	}
+	return true;
+}
+
+/* Entry point of an application processor, called by mpboot.S
+   in 64-bit mode with interrupts off, on the stack that
+   thread_prepare_ap() set up.  Loads the per-CPU state into the
+   processor, takes the big kernel lock, and becomes the idle
+   thread of its CPU. */
+void
+ap_main (void) {
+	struct cpu *c = ap_cpu;
+
+	/* cpu_start_aps()가 기다리다 포기한 CPU는 아무것도 건드리지 않는다 */
+	if (c == NULL)
+		for (;;)
+			asm volatile ("cli; hlt");
+
+	write_msr (MSR_GS_BASE, (uint64_t) c);
+	write_msr (MSR_KERNEL_GS_BASE, 0);
+#ifdef USERPROG
+	tss_init ();
+	gdt_init ();
+	syscall_init_cpu ();
+#endif
+	intr_init_cpu ();
+	lapic_init_ap ();
+
+	bkl_acquire ();
+	cpu_cnt++;
+	thread_start_ap ();
+}
+
+/* Returns true if every CPU is running its idle thread. */
+bool
+cpu_all_idle (void) {
+	for (int i = 0; i < cpu_cnt; i++)
+		if (cpus[i].curr != cpus[i].idle_thread)
+			return false;
+	return true;
+}
+
+/* Wakes up a CPU that is running its idle thread, if any, so
+   that it steals a thread from another CPU's run queue.  Called
+   after a thread has become ready. */
+void
+cpu_kick_idle (void) {
+	enum intr_level old_level = intr_disable ();
+	struct cpu *self = this_cpu ();
+
+	for (int i = 0; i < cpu_cnt; i++) {
+		struct cpu *c = &cpus[i];
+
+		if (c != self && c->curr == c->idle_thread) {
+			lapic_send_ipi (c->lapic_id, LAPIC_RESCHED_VEC);
+			break;
+		}
+	}
+	intr_set_level (old_level);
+}
+
+/* Reschedule IPI handler.  The thread switch on the way out of
+   the interrupt steals work for the idle thread's CPU. */
+static void
+resched_interrupt (struct intr_frame *f UNUSED) {
+	intr_yield_on_return ();
+}
+
+/* Invalidates user page VA of PML4 in the TLB of every other CPU
+   that runs a thread of PML4, and waits until they all have.
+   The caller has already invalidated its own TLB.  Other CPUs
+   do not need the big kernel lock for this, so the caller may
+   hold it; a CPU waiting for the lock polls its request. */
+void
+cpu_tlb_shootdown (uint64_t *pml4 UNUSED, const void *va UNUSED) {
+#ifdef USERPROG
+	enum intr_level old_level;
+	struct cpu *self;
+	bool sent = false;
+
+	if (cpu_cnt == 1)
+		return;
+
+	old_level = intr_disable ();
+	self = this_cpu ();
+	for (int i = 0; i < cpu_cnt; i++) {
+		struct cpu *c = &cpus[i];
+
+		if (c == self || c->curr->pml4 != pml4)
+			continue;
+		c->tlb_va = (uint64_t) va;
+		c->tlb_pending = true;
+		lapic_send_ipi (c->lapic_id, LAPIC_TLB_VEC);
+		sent = true;
+	}
+	if (sent)
+		for (int i = 0; i < cpu_cnt; i++)
+			while (cpus[i].tlb_pending)
+				asm volatile ("pause");
+	intr_set_level (old_level);
+#endif
+}
+
+/* Carries out this CPU's TLB shootdown request, if any.  Runs
+   without the big kernel lock, with interrupts off. */
+void
+cpu_tlb_flush (void) {
+	struct cpu *c = this_cpu ();
+
+	if (c->tlb_pending) {
+		invlpg (c->tlb_va);
+		c->tlb_pending = false;
+	}
+}
+
+/* TLB shootdown IPI handler.  intr_handler() calls it before it
+   takes the big kernel lock. */
+static void
+tlb_interrupt (struct intr_frame *f UNUSED) {
+	cpu_tlb_flush ();
+}
+
+/* Acquires the big kernel lock for this CPU, spinning with
+   interrupts off until it is available.  Interrupts are turned
+   off directly, not with intr_disable(), because this CPU is not
+   in the kernel proper yet. */
+void
+bkl_acquire (void) {
+	uint64_t flags;
+	unsigned ticket;
+
+	asm volatile ("pushfq; popq %0; cli" : "=r" (flags) : : "memory");
+	ASSERT (!bkl_held ());
+
+	ticket = __sync_fetch_and_add (&bkl.next, 1);
+	while (bkl.serving != ticket) {
+		cpu_tlb_flush ();
+		asm volatile ("pause");
+	}
+	barrier ();
+	bkl.owner = this_cpu ()->id;
+
+	asm volatile ("pushq %0; popfq" : : "r" (flags) : "memory", "cc");
+}
+
+/* Releases the big kernel lock, which this CPU must hold, with
+   interrupts off. */
+void
+bkl_release (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (bkl_held ());
+
+	bkl.owner = -1;
+	barrier ();
+	bkl.serving++;
+}
+
+/* Releases the big kernel lock on the way out of the kernel, to
+   user mode or to the idle thread's `hlt'.  Interrupts stay off
+   until iretq or sysretq turns them back on, so that nothing
+   runs in the kernel on this CPU without the lock.  They are
+   turned off directly, because intr_disable() would open an
+   interrupts-off section that never closes. */
+void
+bkl_exit (void) {
+	asm volatile ("cli" : : : "memory");
+	bkl_release ();
+}
+
+/* Lets a CPU that is waiting for the big kernel lock have it,
+   then takes it back.  Must be called with interrupts off at a
+   point where the running thread could also have been switched
+   out. */
+void
+bkl_handoff (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (bkl.next - bkl.serving > 1) {
+		bkl_release ();
+		bkl_acquire ();
+	}
+}
+
+/* Returns true if this CPU holds the big kernel lock. */
+bool
+bkl_held (void) {
+	return bkl.owner == this_cpu ()->id;
+}
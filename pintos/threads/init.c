@@ -13,6 +13,7 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
@@ -21,6 +22,9 @@
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/workqueue.h"
+#include "threads/softirq.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -46,6 +50,9 @@ uint64_t *base_pml4;
 static bool format_filesys;
 #endif
 
+/* -trace: Record kernel tracepoints? */
+static bool trace_requested;
+
 /* -q: Power off after kernel tasks complete? */
 bool power_off_when_done;
 
@@ -86,6 +93,8 @@ main (void) {
 	mem_end = palloc_init ();
 	malloc_init ();
 	paging_init (mem_end);
+	if (trace_requested)
+		trace_init ();
 
 #ifdef USERPROG
 	tss_init ();
@@ -100,11 +109,16 @@ main (void) {
 #ifdef USERPROG
 	exception_init ();
 	syscall_init ();
+	process_cache_init ();
 #endif
 	/* Start thread scheduler and enable interrupts. */
 	thread_start ();
+	workqueue_init ();
+	softirq_start ();
+	palloc_zero_start ();
 	serial_init_queue ();
 	timer_calibrate ();
+	cpu_start_aps ();
 
 #ifdef FILESYS
 	/* Initialize file system. */
@@ -219,8 +233,19 @@ parse_options (char **argv) {
 #endif
 		else if (!strcmp (name, "-rs"))
 			random_init (atoi (value));
-		else if (!strcmp (name, "-mlfqs"))
+		else if (!strcmp (name, "-mlfqs")) {
 			thread_mlfqs = true;
+			thread_cfs = false;
+		} else if (!strcmp (name, "-cfs")) {
+			thread_cfs = true;
+			thread_mlfqs = false;
+		}
+		else if (!strcmp (name, "-donate-depth"))
+			lock_donate_depth = atoi (value);
+		else if (!strcmp (name, "-tc"))
+			thread_cache_max = atoi (value);
+		else if (!strcmp (name, "-trace"))
+			trace_requested = true;
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
@@ -326,6 +351,10 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -cfs               Use completely fair scheduler.\n"
+			"  -donate-depth=N    Donate priority through at most N nested locks.\n"
+			"  -tc=N              Keep up to N exited thread pages for reuse.\n"
+			"  -trace             Record tracepoints, dump them to scratch disk.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
@@ -340,6 +369,7 @@ void
 power_off (void) {
 #ifdef FILESYS
 	filesys_done ();
+	trace_dump ();
 #endif
 
 	print_stats ();
@@ -354,6 +384,14 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+	palloc_print_stats ();
+	malloc_print_stats ();
+	kmem_cache_print_stats ();
+	softirq_print_stats ();
+	intr_print_stats ();
+#ifdef LOCKSTAT
+	lock_print_stats ();
+#endif
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
@@ -3,16 +3,22 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
+#include "threads/softirq.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
+#include "devices/lapic.h"
 #include "devices/timer.h"
 #include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/gdt.h"
+#include "userprog/process.h"
 #endif
 
 /* Number of x86_64 interrupts. */
@@ -99,7 +105,8 @@ static const char *intr_names[INTR_CNT];
    pre-empted.  Handlers for external interrupts also may not
    sleep, although they may invoke intr_yield_on_return() to
    request that a new process be scheduled just before the
-   interrupt returns. */
+   interrupt returns.  Only the CPU holding the big kernel lock
+   handles them, so one flag of each kind is enough. */
 static bool in_external_intr;   /* Are we processing an external interrupt? */
 static bool yield_on_return;    /* Should we yield on interrupt return? */
 
@@ -107,6 +114,40 @@ static bool yield_on_return;    /* Should we yield on interrupt return? */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
 
+static enum intr_level do_enable (void *caller);
+static enum intr_level do_disable (void *caller);
+
+#ifdef IRQSOFF
+/* Interrupts-off latency tracer.
+
+   Every switch from INTR_ON to INTR_OFF, through intr_disable()
+   or the CPU entering an interrupt gate, stamps the TSC and the
+   caller's return address.  The matching switch back closes the
+   section, which goes into a histogram of log2(nanoseconds) and,
+   if it is among the IRQSOFF_WORST longest so far, into a table
+   with both addresses.  Sections that end by iretq into a new
+   thread are not seen and are dropped.  All of this runs with
+   interrupts off. */
+#define IRQSOFF_WORST 8
+
+/* One interrupts-off section. */
+struct irqsoff_section {
+	uint64_t cycles;            /* Length in TSC cycles. */
+	void *off;                  /* Where interrupts were turned off. */
+	void *on;                   /* Where they were turned back on. */
+};
+
+static bool irqsoff_open;       /* Section in progress? */
+static uint64_t irqsoff_start;  /* TSC when it began. */
+static void *irqsoff_caller;    /* Where it began. */
+static uint64_t irqsoff_cnt;    /* # of sections. */
+static uint64_t irqsoff_hist[64];       /* By log2 of length in ns. */
+static struct irqsoff_section irqsoff_worst[IRQSOFF_WORST];  /* Longest first. */
+
+static void irqsoff_begin (void *caller);
+static void irqsoff_end (void *caller);
+#endif
+
 /* Interrupt handlers. */
 void intr_handler (struct intr_frame *args);
 
@@ -128,15 +169,45 @@ intr_get_level (void) {
    returns the previous interrupt status. */
 enum intr_level
 intr_set_level (enum intr_level level) {
-	return level == INTR_ON ? intr_enable () : intr_disable ();
+	void *caller = __builtin_return_address (0);
+
+	return level == INTR_ON ? do_enable (caller) : do_disable (caller);
 }
 
 /* Enables interrupts and returns the previous interrupt status. */
 enum intr_level
 intr_enable (void) {
+	return do_enable (__builtin_return_address (0));
+}
+
+/* Disables interrupts and returns the previous interrupt status. */
+enum intr_level
+intr_disable (void) {
+	return do_disable (__builtin_return_address (0));
+}
+
+/* Tells the interrupts-off tracer that interrupts are about to
+   be enabled without intr_enable(), as by the idle thread's
+   `sti; hlt'.  Interrupts must be off. */
+void
+intr_mark_enable (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+#ifdef IRQSOFF
+	irqsoff_end (__builtin_return_address (0));
+#endif
+}
+
+/* intr_enable()의 본체. CALLER는 tracer에 기록할 호출 위치 */
+static enum intr_level
+do_enable (void *caller UNUSED) {
 	enum intr_level old_level = intr_get_level ();
 	ASSERT (!intr_context ());
 
+#ifdef IRQSOFF
+	if (old_level == INTR_OFF)
+		irqsoff_end (caller);
+#endif
+
 	/* Enable interrupts by setting the interrupt flag.
 
 	   See [IA32-v2b] "STI" and [IA32-v3a] 5.8.1 "Masking Maskable
@@ -146,9 +217,9 @@ intr_enable (void) {
 	return old_level;
 }
 
-/* Disables interrupts and returns the previous interrupt status. */
-enum intr_level
-intr_disable (void) {
+/* intr_disable()의 본체. CALLER는 tracer에 기록할 호출 위치 */
+static enum intr_level
+do_disable (void *caller UNUSED) {
 	enum intr_level old_level = intr_get_level ();
 
 	/* Disable interrupts by clearing the interrupt flag.
@@ -156,6 +227,11 @@ intr_disable (void) {
 	   Hardware Interrupts". */
 	asm volatile ("cli" : : : "memory");
 
+#ifdef IRQSOFF
+	if (old_level == INTR_ON)
+		irqsoff_begin (caller);
+#endif
+
 	return old_level;
 }
 
@@ -173,13 +249,7 @@ intr_init (void) {
 		intr_names[i] = "unknown";
 	}
 
-#ifdef USERPROG
-	/* Load TSS. */
-	ltr (SEL_TSS);
-#endif
-
-	/* Load IDT register. */
-	lidt(&idt_desc);
+	intr_init_cpu ();
 
 	/* Initialize intr_names. */
 	intr_names[0] = "#DE Divide Error";
@@ -203,6 +273,19 @@ intr_init (void) {
 	intr_names[19] = "#XF SIMD Floating-Point Exception";
 }
 
+/* Loads the TSS and the IDT into the current CPU.  All CPUs
+   share the IDT. */
+void
+intr_init_cpu (void) {
+#ifdef USERPROG
+	/* Load TSS. */
+	ltr (SEL_TSS);
+#endif
+
+	/* Load IDT register. */
+	lidt(&idt_desc);
+}
+
 /* Registers interrupt VEC_NO to invoke HANDLER with descriptor
    privilege level DPL.  Names the interrupt NAME for debugging
    purposes.  The interrupt handler will be invoked with
@@ -223,11 +306,12 @@ register_handler (uint8_t vec_no, int dpl, enum intr_level level,
 
 /* Registers external interrupt VEC_NO to invoke HANDLER, which
    is named NAME for debugging purposes.  The handler will
-   execute with interrupts disabled. */
+   execute with interrupts disabled.  Vectors 0x20...0x2f come
+   from the PICs, 0x30...0x3f from the local APIC. */
 void
 intr_register_ext (uint8_t vec_no, intr_handler_func *handler,
 		const char *name) {
-	ASSERT (vec_no >= 0x20 && vec_no <= 0x2f);
+	ASSERT (vec_no >= 0x20 && vec_no <= 0x3f);
 	register_handler (vec_no, 0, INTR_OFF, handler, name);
 }
 
@@ -248,7 +332,7 @@ void
 intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
 		intr_handler_func *handler, const char *name)
 {
-	ASSERT (vec_no < 0x20 || vec_no > 0x2f);
+	ASSERT (vec_no < 0x20 || vec_no > 0x3f);
 	register_handler (vec_no, dpl, level, handler, name);
 }
 
@@ -259,13 +343,13 @@ intr_context (void) {
 	return in_external_intr;
 }
 
-/* During processing of an external interrupt, directs the
-   interrupt handler to yield to a new process just before
-   returning from the interrupt.  May not be called at any other
-   time. */
+/* During processing of an external interrupt or of the
+   softirqs that follow it, directs the interrupt handler to
+   yield to a new process just before returning from the
+   interrupt.  May not be called at any other time. */
 void
 intr_yield_on_return (void) {
-	ASSERT (intr_context ());
+	ASSERT (intr_context () || softirq_context ());
 	yield_on_return = true;
 }
 
@@ -330,24 +414,55 @@ pic_end_of_interrupt (int irq) {
    interrupted thread's registers. */
 void
 intr_handler (struct intr_frame *frame) {
-	bool external;
+	bool external, took;
 	intr_handler_func *handler;
 
+	/* TLB shootdown은 big kernel lock을 기다리는 CPU도 받아야 하므로
+	   lock 없이 바로 처리한다 */
+	if (frame->vec_no == LAPIC_TLB_VEC) {
+		intr_handlers[LAPIC_TLB_VEC] (frame);
+		lapic_eoi ();
+		return;
+	}
+
+	/* 유저 모드나 idle 스레드의 hlt에서 들어왔다면 lock이 없다.
+	   커널 안에서 들어왔다면 이 CPU가 이미 갖고 있다 */
+	took = !bkl_held ();
+	if (took)
+		bkl_acquire ();
+
 	/* External interrupts are special.
 	   We only handle one at a time (so interrupts must be off)
-	   and they need to be acknowledged on the PIC (see below).
+	   and they need to be acknowledged on the PIC or the local
+	   APIC (see below).
 	   An external interrupt handler cannot sleep. */
-	external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+	TRACE (TRACE_INTR_ENTER, frame->vec_no);
+	external = frame->vec_no >= 0x20 && frame->vec_no < 0x40;
 	if (external) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (!intr_context ());
 
 		in_external_intr = true;
-		yield_on_return = false;
+
+		/* softirq 처리 도중에 들어온 인터럽트라면 바깥쪽이 요청한
+		   양보를 지우지 않는다 */
+		if (!softirq_context ())
+			yield_on_return = false;
 	}
 
+#ifdef USERPROG
+	/* 유저 모드에서 들어왔으면 지금까지의 시간은 유저 시간 */
+	if (frame->cs == SEL_UCSEG)
+		thread_charge_user ();
+#endif
+
 	/* Invoke the interrupt's handler. */
 	handler = intr_handlers[frame->vec_no];
+#ifdef IRQSOFF
+	/* interrupt gate로 들어오면서 CPU가 인터럽트를 껐다 */
+	if ((frame->eflags & FLAG_IF) && intr_get_level () == INTR_OFF)
+		irqsoff_begin (handler != NULL ? (void *) handler : (void *) intr_handler);
+#endif
 	if (handler != NULL)
 		handler (frame);
 	else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f) {
@@ -360,6 +475,7 @@ intr_handler (struct intr_frame *frame) {
 		intr_dump_frame (frame);
 		PANIC ("Unexpected interrupt");
 	}
+	TRACE (TRACE_INTR_EXIT, frame->vec_no);
 
 	/* Complete the processing of an external interrupt. */
 	if (external) {
@@ -367,11 +483,102 @@ intr_handler (struct intr_frame *frame) {
 		ASSERT (intr_context ());
 
 		in_external_intr = false;
-		pic_end_of_interrupt (frame->vec_no);
+		if (frame->vec_no < 0x30)
+			pic_end_of_interrupt (frame->vec_no);
+		else
+			lapic_eoi ();
+
+		/* 미뤄둔 softirq를 인터럽트를 켠 채로 처리한다.
+		   softirq 도중에 끼어든 인터럽트는 raise만 해두고 돌아가며,
+		   양보도 바깥쪽 softirq 처리가 끝난 뒤에 한 번에 한다. */
+		if (!softirq_context ()) {
+			softirq_run ();
+			if (yield_on_return)
+				thread_yield ();
+			else if (!took)
+				bkl_handoff ();
+		}
+	}
+
+#ifdef USERPROG
+	if (frame->cs == SEL_UCSEG) {
+		thread_charge_system ();
 
-		if (yield_on_return)
-			thread_yield ();
+		/* 같은 프로세스의 다른 스레드가 exit() 했다면 유저 모드로 돌아가지 않는다 */
+		process_check_exiting ();
 	}
+#endif
+
+#ifdef IRQSOFF
+	/* iretq가 인터럽트를 다시 켠다 */
+	if ((frame->eflags & FLAG_IF) && intr_get_level () == INTR_OFF)
+		irqsoff_end (handler != NULL ? (void *) handler : (void *) intr_handler);
+#endif
+
+	/* 인터럽트가 다른 CPU로 옮겨간 스레드에서 끝날 수도 있지만,
+	   그 CPU도 커널을 실행 중이므로 lock을 갖고 있다 */
+	if (took)
+		bkl_exit ();
+}
+
+#ifdef IRQSOFF
+/* Starts an interrupts-off section at CALLER. */
+static void
+irqsoff_begin (void *caller) {
+	irqsoff_open = true;
+	irqsoff_start = rdtsc ();
+	irqsoff_caller = caller;
+}
+
+/* Ends the interrupts-off section in progress, if any, at
+   CALLER and records its length. */
+static void
+irqsoff_end (void *caller) {
+	uint64_t cycles;
+	int i;
+
+	if (!irqsoff_open)
+		return;
+	irqsoff_open = false;
+	cycles = rdtsc () - irqsoff_start;
+
+	irqsoff_cnt++;
+	irqsoff_hist[63 - __builtin_clzll (timer_tsc_to_ns (cycles) | 1)]++;
+
+	/* 가장 긴 것부터 정렬된 표에 자리를 찾아 끼워 넣는다 */
+	for (i = IRQSOFF_WORST; i > 0 && irqsoff_worst[i - 1].cycles < cycles; i--)
+		if (i < IRQSOFF_WORST)
+			irqsoff_worst[i] = irqsoff_worst[i - 1];
+	if (i < IRQSOFF_WORST)
+		irqsoff_worst[i] = (struct irqsoff_section) {
+			.cycles = cycles, .off = irqsoff_caller, .on = caller };
+}
+#endif
+
+/* Prints the interrupts-off histogram and the longest sections.
+   Prints nothing unless the kernel is built with IRQSOFF.  Pass
+   the addresses to the `backtrace' utility to symbolize them. */
+void
+intr_print_stats (void) {
+#ifdef IRQSOFF
+	enum intr_level old_level = intr_disable ();
+	uint64_t hist[64];
+	struct irqsoff_section worst[IRQSOFF_WORST];
+	uint64_t cnt = irqsoff_cnt;
+
+	memcpy (hist, irqsoff_hist, sizeof hist);
+	memcpy (worst, irqsoff_worst, sizeof worst);
+	intr_set_level (old_level);
+
+	printf ("Interrupts off: %"PRIu64" sections\n", cnt);
+	for (int i = 0; i < 64; i++)
+		if (hist[i] != 0)
+			printf ("  %12"PRIu64" ns or more: %"PRIu64"\n", 1ULL << i, hist[i]);
+	printf ("Longest interrupts-off sections (off at, on at):\n");
+	for (int i = 0; i < IRQSOFF_WORST && worst[i].cycles != 0; i++)
+		printf ("  %12"PRIu64" ns: %p %p\n",
+				timer_tsc_to_ns (worst[i].cycles), worst[i].off, worst[i].on);
+#endif
 }
 
 /* Dumps interrupt frame F to the console, for debugging. */
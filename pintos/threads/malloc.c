@@ -5,38 +5,69 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
 
-   The size of each request, in bytes, is rounded up to a power
-   of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
-   the free list is nonempty, one of its blocks is used to
-   satisfy the request.
+   The size of each request, in bytes, is rounded up to the
+   nearest size class and assigned to the "descriptor" that
+   manages blocks of that size.  Size classes are powers of 2 up
+   to 1 kB, then both 2^N and 3 * 2^(N-1) up to MEDIUM_MAX.  The
+   descriptor keeps a list of free blocks.  If the free list is
+   nonempty, one of its blocks is used to satisfy the request.
 
    Otherwise, a new page of memory, called an "arena", is
    obtained from the page allocator (if none is available,
-   malloc() returns a null pointer).  The new arena is divided
-   into blocks, all of which are added to the descriptor's free
-   list.  Then we return one of the new blocks.
+   malloc() returns a null pointer).  Arenas for "medium" blocks,
+   above 1 kB, span ARENA_PAGES pages, chosen per descriptor so
+   that little of the arena goes unused; palloc_set_owner() makes
+   each of its pages point back to the arena header.  The new
+   arena is divided into blocks, all of which are added to the
+   descriptor's free list.  Then we return one of the new
+   blocks.
 
    When we free a block, we add it to its descriptor's free list.
    But if the arena that the block was in now has no in-use
    blocks, we remove all of the arena's blocks from the free list
    and give the arena back to the page allocator.
 
-   We can't handle blocks bigger than 2 kB using this scheme,
-   because they're too big to fit in a single page with a
-   descriptor.  We handle those by allocating contiguous pages
-   with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   In front of each descriptor, every CPU has a "magazine": a
+   small stack of free blocks that only that CPU touches, with
+   interrupts off instead of a lock.  malloc() pops a block from
+   the magazine and free() pushes one, so the common case takes
+   no lock and touches no shared memory.  Only when the magazine
+   is empty does malloc() take the descriptor's lock and refill
+   it with MAG_BATCH blocks, and only when it is full does free()
+   drain MAG_BATCH blocks back to the free list.  Blocks in a
+   magazine count as in use for their arena.  Medium blocks have
+   no magazines, which would hold on to too much memory.
+
+   Blocks bigger than MEDIUM_MAX are handled by allocating
+   contiguous pages with the page allocator and sticking the
+   allocation size at the beginning of the allocated block's
+   arena header.  realloc() grows such a block in place when the
+   pages after it are free.
+
+   Object caches (kmem_cache) are built on the same arenas.  A
+   cache hands out objects of one exact size, so a 40-byte object
+   takes 40 bytes rather than 64, from single-page "slabs" whose
+   arena header points back to the cache.  A cache may have a
+   constructor, which runs once per object when its slab is
+   created rather than on every allocation: an object must be
+   returned to its cache in its constructed state, and the next
+   kmem_cache_alloc() hands it out as is.  The slab keeps the
+   indexes of its free objects in an array after its header, so
+   that free objects are never written to.  free() also accepts
+   objects from a cache. */
 
 /* Descriptor. */
 struct desc {
 	size_t block_size;          /* Size of each element in bytes. */
+	size_t arena_pages;         /* Number of pages in an arena. */
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
 	struct list free_list;      /* List of free blocks. */
 	struct lock lock;           /* Lock. */
@@ -49,34 +80,110 @@ struct desc {
 struct arena {
 	unsigned magic;             /* Always set to ARENA_MAGIC. */
 	struct desc *desc;          /* Owning descriptor, null for big block. */
+	struct kmem_cache *cache;   /* Owning cache, null unless a slab. */
 	size_t free_cnt;            /* Free blocks; pages in big block. */
 };
 
+/* Object cache. */
+struct kmem_cache {
+	const char *name;           /* Name, for statistics. */
+	size_t size;                /* Object size, a multiple of ALIGN. */
+	size_t objs_per_slab;       /* Number of objects in a slab. */
+	size_t obj_ofs;             /* Offset of first object in a slab. */
+	kmem_ctor_func *ctor;       /* Constructor, or null. */
+	struct list partial;        /* Slabs with used and free objects. */
+	struct list full;           /* Slabs without free objects. */
+	struct list empty;          /* Slabs without used objects. */
+	struct lock lock;           /* Lock. */
+	struct list_elem elem;      /* Element in `caches'. */
+
+	/* Statistics. */
+	size_t slab_cnt;            /* # of slabs. */
+	size_t in_use;              /* # of objects allocated. */
+	long long alloc_cnt;        /* # of kmem_cache_alloc() calls. */
+	long long grow_cnt;         /* # of slabs created. */
+	long long reap_cnt;         /* # of slabs returned to palloc. */
+};
+
+/* Slab: an arena holding the objects of a kmem_cache. */
+struct slab {
+	struct arena arena;         /* free_cnt = # of free objects. */
+	struct list_elem elem;      /* Element in a cache's slab list. */
+	uint16_t free_idx[];        /* Indexes of free objects, free_cnt
+	                               of them. */
+};
+
 /* Free block. */
 struct block {
 	struct list_elem free_elem; /* Free list element. */
 };
 
+/* Largest medium block, and the most pages in a medium arena. */
+#define MEDIUM_MAX (64 * 1024)
+#define MEDIUM_ARENA_PAGES_MAX 64
+
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+#define DESC_MAX 24
+static struct desc descs[DESC_MAX]; /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
+static size_t small_desc_cnt;   /* Number of single-page descriptors,
+                                   which come first. */
+
+/* Magazine capacity, and the number of blocks moved between a
+   magazine and its descriptor at a time. */
+#define MAG_SIZE 16
+#define MAG_BATCH (MAG_SIZE / 2)
+
+/* Per-CPU cache of free blocks of one descriptor. */
+struct magazine {
+	size_t cnt;                 /* # of blocks in BLOCKS. */
+	struct block *blocks[MAG_SIZE]; /* Free blocks, top at CNT - 1. */
+};
+
+/* One CPU's magazines, in a cache line of their own. */
+#define MAG_DESC_MAX 10
+struct cpu_mags {
+	struct magazine mags[MAG_DESC_MAX]; /* For small descriptors. */
+
+	/* Statistics. */
+	long long hit_cnt;          /* # of mallocs from a magazine. */
+	long long refill_cnt;       /* # of refills from a descriptor. */
+	long long drain_cnt;        /* # of drains to a descriptor. */
+} __attribute__ ((aligned (64)));
+
+static struct cpu_mags cpu_mags[NCPU_MAX];
+
+/* All object caches, for statistics. */
+static struct list caches;
+static struct lock caches_lock;
 
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static struct block *desc_get_block (struct desc *);
+static void desc_put_block (struct desc *, struct block *);
+static void desc_init (size_t block_size, size_t arena_pages);
+static size_t medium_arena_pages (size_t block_size);
+static bool resize_in_place (void *block, size_t new_size);
+static struct slab *slab_create (struct kmem_cache *);
+static void *slab_obj (struct kmem_cache *, struct slab *, size_t idx);
 
 /* Initializes the malloc() descriptors. */
 void
 malloc_init (void) {
 	size_t block_size;
 
-	for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2) {
-		struct desc *d = &descs[desc_cnt++];
-		ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
-		d->block_size = block_size;
-		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
-		list_init (&d->free_list);
-		lock_init (&d->lock);
+	for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2)
+		desc_init (block_size, 1);
+	small_desc_cnt = desc_cnt;
+	ASSERT (small_desc_cnt <= MAG_DESC_MAX);
+
+	/* Medium: 1.5 kB, 2 kB, 3 kB, 4 kB, ..., 48 kB, 64 kB. */
+	for (block_size = PGSIZE / 2; block_size <= MEDIUM_MAX; block_size *= 2) {
+		desc_init (block_size / 4 * 3, medium_arena_pages (block_size / 4 * 3));
+		desc_init (block_size, medium_arena_pages (block_size));
 	}
+	list_init (&caches);
+	lock_init_named (&caches_lock, "kmem_caches");
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -86,6 +193,9 @@ malloc (size_t size) {
 	struct desc *d;
 	struct block *b;
 	struct arena *a;
+	struct cpu_mags *cm;
+	struct magazine *m;
+	enum intr_level old_level;
 
 	/* A null pointer satisfies a request for 0 bytes. */
 	if (size == 0)
@@ -108,37 +218,44 @@ malloc (size_t size) {
 		   pages, and return it. */
 		a->magic = ARENA_MAGIC;
 		a->desc = NULL;
+		a->cache = NULL;
 		a->free_cnt = page_cnt;
 		return a + 1;
 	}
 
-	lock_acquire (&d->lock);
-
-	/* If the free list is empty, create a new arena. */
-	if (list_empty (&d->free_list)) {
-		size_t i;
-
-		/* Allocate a page. */
-		a = palloc_get_page (0);
-		if (a == NULL) {
-			lock_release (&d->lock);
-			return NULL;
-		}
+	if (d - descs >= (ptrdiff_t) small_desc_cnt) {
+		lock_acquire (&d->lock);
+		b = desc_get_block (d);
+		lock_release (&d->lock);
+		return b;
+	}
 
-		/* Initialize arena and add its blocks to the free list. */
-		a->magic = ARENA_MAGIC;
-		a->desc = d;
-		a->free_cnt = d->blocks_per_arena;
-		for (i = 0; i < d->blocks_per_arena; i++) {
-			struct block *b = arena_to_block (a, i);
-			list_push_back (&d->free_list, &b->free_elem);
-		}
+	/* Fast path: pop a block from this CPU's magazine. */
+	old_level = intr_disable ();
+	cm = &cpu_mags[this_cpu ()->id];
+	m = &cm->mags[d - descs];
+	if (m->cnt > 0) {
+		b = m->blocks[--m->cnt];
+		cm->hit_cnt++;
+		intr_set_level (old_level);
+		return b;
 	}
+	intr_set_level (old_level);
 
-	/* Get a block from free list and return it. */
-	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-	a = block_to_arena (b);
-	a->free_cnt--;
+	/* 매거진이 비었으면 descriptor에서 MAG_BATCH개를 한 번에 가져온다.
+	   lock을 기다리는 사이 같은 CPU의 다른 스레드가 채웠을 수도 있으므로
+	   인터럽트를 끈 뒤 다시 확인한다 */
+	lock_acquire (&d->lock);
+	old_level = intr_disable ();
+	cm = &cpu_mags[this_cpu ()->id];
+	m = &cm->mags[d - descs];
+	if (m->cnt == 0) {
+		cm->refill_cnt++;
+		while (m->cnt < MAG_BATCH && (b = desc_get_block (d)) != NULL)
+			m->blocks[m->cnt++] = b;
+	}
+	b = m->cnt > 0 ? m->blocks[--m->cnt] : NULL;
+	intr_set_level (old_level);
 	lock_release (&d->lock);
 	return b;
 }
@@ -170,7 +287,35 @@ block_size (void *block) {
 	struct arena *a = block_to_arena (b);
 	struct desc *d = a->desc;
 
-	return d != NULL ? d->block_size : PGSIZE * a->free_cnt - pg_ofs (block);
+	if (a->cache != NULL)
+		return a->cache->size;
+	return d != NULL ? d->block_size : PGSIZE * a->free_cnt - sizeof *a;
+}
+
+/* Tries to make BLOCK hold NEW_SIZE bytes without moving it.
+   Returns true if successful, false otherwise. */
+static bool
+resize_in_place (void *block, size_t new_size) {
+	struct arena *a = block_to_arena (block);
+	size_t page_cnt;
+
+	if (a->desc != NULL || a->cache != NULL)
+		return new_size <= block_size (block);
+
+	/* 큰 block은 페이지 단위로 줄이거나, 바로 뒤 페이지들이
+	   비어있으면 그만큼 늘린다 */
+	page_cnt = DIV_ROUND_UP (new_size + sizeof *a, PGSIZE);
+	if (page_cnt <= a->free_cnt) {
+		palloc_free_multiple ((uint8_t *) a + page_cnt * PGSIZE,
+				a->free_cnt - page_cnt);
+		a->free_cnt = page_cnt;
+		return true;
+	}
+	if (palloc_extend (a, a->free_cnt, page_cnt)) {
+		a->free_cnt = page_cnt;
+		return true;
+	}
+	return false;
 }
 
 /* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
@@ -184,6 +329,8 @@ realloc (void *old_block, size_t new_size) {
 	if (new_size == 0) {
 		free (old_block);
 		return NULL;
+	} else if (old_block != NULL && resize_in_place (old_block, new_size)) {
+		return old_block;
 	} else {
 		void *new_block = malloc (new_size);
 		if (old_block != NULL && new_block != NULL) {
@@ -205,31 +352,54 @@ free (void *p) {
 		struct arena *a = block_to_arena (b);
 		struct desc *d = a->desc;
 
-		if (d != NULL) {
+		if (a->cache != NULL) {
+			/* It's an object from a cache. */
+			kmem_cache_free (a->cache, p);
+		} else if (d != NULL) {
 			/* It's a normal block.  We handle it here. */
+			struct cpu_mags *cm;
+			struct magazine *m;
+			enum intr_level old_level;
 
 #ifndef NDEBUG
 			/* Clear the block to help detect use-after-free bugs. */
 			memset (b, 0xcc, d->block_size);
 #endif
 
-			lock_acquire (&d->lock);
-
-			/* Add block to free list. */
-			list_push_front (&d->free_list, &b->free_elem);
-
-			/* If the arena is now entirely unused, free it. */
-			if (++a->free_cnt >= d->blocks_per_arena) {
-				size_t i;
+			if (d - descs >= (ptrdiff_t) small_desc_cnt) {
+				lock_acquire (&d->lock);
+				desc_put_block (d, b);
+				lock_release (&d->lock);
+				return;
+			}
 
-				ASSERT (a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++) {
-					struct block *b = arena_to_block (a, i);
-					list_remove (&b->free_elem);
-				}
-				palloc_free_page (a);
+			/* Fast path: push the block onto this CPU's magazine. */
+			old_level = intr_disable ();
+			cm = &cpu_mags[this_cpu ()->id];
+			m = &cm->mags[d - descs];
+			if (m->cnt < MAG_SIZE) {
+				m->blocks[m->cnt++] = b;
+				intr_set_level (old_level);
+				return;
 			}
+			intr_set_level (old_level);
 
+			/* 매거진이 가득 찼으면 아래쪽(오래된) MAG_BATCH개를
+			   descriptor의 free list로 돌려준다 */
+			lock_acquire (&d->lock);
+			old_level = intr_disable ();
+			cm = &cpu_mags[this_cpu ()->id];
+			m = &cm->mags[d - descs];
+			if (m->cnt == MAG_SIZE) {
+				cm->drain_cnt++;
+				for (size_t i = 0; i < MAG_BATCH; i++)
+					desc_put_block (d, m->blocks[i]);
+				memmove (m->blocks, m->blocks + MAG_BATCH,
+						(MAG_SIZE - MAG_BATCH) * sizeof *m->blocks);
+				m->cnt -= MAG_BATCH;
+			}
+			m->blocks[m->cnt++] = b;
+			intr_set_level (old_level);
 			lock_release (&d->lock);
 		} else {
 			/* It's a big block.  Free its pages. */
@@ -239,19 +409,327 @@ free (void *p) {
 	}
 }
 
+/* Prints malloc() magazine statistics. */
+void
+malloc_print_stats (void) {
+	long long hit_cnt = 0, refill_cnt = 0, drain_cnt = 0;
+
+	for (int i = 0; i < cpu_cnt; i++) {
+		hit_cnt += cpu_mags[i].hit_cnt;
+		refill_cnt += cpu_mags[i].refill_cnt;
+		drain_cnt += cpu_mags[i].drain_cnt;
+	}
+	printf ("Malloc: %lld magazine hits, %lld refills, %lld drains\n",
+			hit_cnt, refill_cnt, drain_cnt);
+}
+
+/* Takes a block off D's free list, creating a new arena if the
+   list is empty.  Returns a null pointer if memory is not
+   available.  D's lock must be held. */
+static struct block *
+desc_get_block (struct desc *d) {
+	struct block *b;
+	struct arena *a;
+
+	ASSERT (lock_held_by_current_thread (&d->lock));
+
+	/* If the free list is empty, create a new arena. */
+	if (list_empty (&d->free_list)) {
+		size_t i;
+
+		/* Allocate an arena. */
+		a = palloc_get_multiple (0, d->arena_pages);
+		if (a == NULL)
+			return NULL;
+		if (d->arena_pages > 1)
+			for (i = 0; i < d->arena_pages; i++)
+				palloc_set_owner ((uint8_t *) a + i * PGSIZE, a);
+
+		/* Initialize arena and add its blocks to the free list. */
+		a->magic = ARENA_MAGIC;
+		a->desc = d;
+		a->cache = NULL;
+		a->free_cnt = d->blocks_per_arena;
+		for (i = 0; i < d->blocks_per_arena; i++) {
+			struct block *b = arena_to_block (a, i);
+			list_push_back (&d->free_list, &b->free_elem);
+		}
+	}
+
+	/* Get a block from free list. */
+	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
+	a = block_to_arena (b);
+	a->free_cnt--;
+	return b;
+}
+
+/* Puts block B back on D's free list, giving its arena back to
+   the page allocator if the arena is now unused.  D's lock must
+   be held. */
+static void
+desc_put_block (struct desc *d, struct block *b) {
+	struct arena *a = block_to_arena (b);
+
+	ASSERT (lock_held_by_current_thread (&d->lock));
+	ASSERT (a->desc == d);
+
+	/* Add block to free list. */
+	list_push_front (&d->free_list, &b->free_elem);
+
+	/* If the arena is now entirely unused, free it. */
+	if (++a->free_cnt >= d->blocks_per_arena) {
+		size_t i;
+
+		ASSERT (a->free_cnt == d->blocks_per_arena);
+		for (i = 0; i < d->blocks_per_arena; i++) {
+			struct block *b = arena_to_block (a, i);
+			list_remove (&b->free_elem);
+		}
+		palloc_free_multiple (a, d->arena_pages);
+	}
+}
+
+/* Adds a descriptor for blocks of BLOCK_SIZE bytes in arenas of
+   ARENA_PAGES pages. */
+static void
+desc_init (size_t block_size, size_t arena_pages) {
+	struct desc *d = &descs[desc_cnt++];
+	char name[LOCKSTAT_NAME_LEN];
+
+	ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
+	d->block_size = block_size;
+	d->arena_pages = arena_pages;
+	d->blocks_per_arena = (arena_pages * PGSIZE - sizeof (struct arena))
+		/ block_size;
+	ASSERT (d->blocks_per_arena > 0);
+	list_init (&d->free_list);
+	snprintf (name, sizeof name, "malloc%zu", block_size);
+	lock_init_named (&d->lock, name);
+}
+
+/* Returns the number of pages for an arena of medium blocks of
+   BLOCK_SIZE bytes: the fewest that hold at least two blocks and
+   leave no more than an eighth of the arena unused. */
+static size_t
+medium_arena_pages (size_t block_size) {
+	size_t pages;
+
+	for (pages = 1; pages < MEDIUM_ARENA_PAGES_MAX; pages++) {
+		size_t bytes = pages * PGSIZE;
+		size_t cnt = (bytes - sizeof (struct arena)) / block_size;
+
+		if (cnt >= 2 && (bytes - cnt * block_size) * 8 <= bytes)
+			break;
+	}
+	return pages;
+}
+
+/* Creates and returns an object cache named NAME for objects of
+   SIZE bytes aligned on ALIGN bytes, a power of 2, or on a
+   pointer if ALIGN is 0.  If CTOR is nonnull, it is called on
+   each object once, before the object is first allocated.  NAME
+   must stay valid as long as the cache exists.  Returns a null
+   pointer if memory is not available. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, size_t align,
+		kmem_ctor_func *ctor) {
+	struct kmem_cache *c;
+	size_t n;
+
+	if (align == 0)
+		align = sizeof (void *);
+	ASSERT (name != NULL);
+	ASSERT (size > 0);
+	ASSERT ((align & (align - 1)) == 0);
+
+	c = malloc (sizeof *c);
+	if (c == NULL)
+		return NULL;
+
+	c->name = name;
+	c->size = ROUND_UP (size, align);
+	c->ctor = ctor;
+
+	/* 한 slab에 들어가는 객체 수: 헤더, 인덱스 배열, 정렬 패딩을
+	   빼고 남은 공간에 들어갈 수 있는 최대 개수 */
+	n = (PGSIZE - sizeof (struct slab)) / (c->size + sizeof (uint16_t));
+	while (n > 0 && ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t),
+				align) + n * c->size > PGSIZE)
+		n--;
+	ASSERT (n > 0);
+	c->objs_per_slab = n;
+	c->obj_ofs = ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t), align);
+
+	list_init (&c->partial);
+	list_init (&c->full);
+	list_init (&c->empty);
+	lock_init_named (&c->lock, name);
+	c->slab_cnt = c->in_use = 0;
+	c->alloc_cnt = c->grow_cnt = c->reap_cnt = 0;
+
+	lock_acquire (&caches_lock);
+	list_push_back (&caches, &c->elem);
+	lock_release (&caches_lock);
+	return c;
+}
+
+/* Allocates and returns an object from cache C.  If C has a
+   constructor, the object is in its constructed state.  Returns
+   a null pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c) {
+	struct slab *s;
+	void *obj;
+
+	lock_acquire (&c->lock);
+
+	/* 일부만 사용중인 slab을 먼저 쓰고, 다음으로 빈 slab,
+	   둘 다 없으면 새 slab을 만든다 */
+	if (!list_empty (&c->partial))
+		s = list_entry (list_front (&c->partial), struct slab, elem);
+	else if (!list_empty (&c->empty)) {
+		s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+		list_push_front (&c->partial, &s->elem);
+	} else {
+		s = slab_create (c);
+		if (s == NULL) {
+			lock_release (&c->lock);
+			return NULL;
+		}
+		list_push_front (&c->partial, &s->elem);
+	}
+
+	obj = slab_obj (c, s, s->free_idx[--s->arena.free_cnt]);
+	if (s->arena.free_cnt == 0) {
+		list_remove (&s->elem);
+		list_push_front (&c->full, &s->elem);
+	}
+	c->in_use++;
+	c->alloc_cnt++;
+	lock_release (&c->lock);
+	return obj;
+}
+
+/* Returns OBJ, which must have been allocated from cache C, to
+   C.  If C has a constructor, OBJ must be in its constructed
+   state.  A null OBJ is ignored. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj) {
+	struct slab *s;
+	size_t idx;
+
+	if (obj == NULL)
+		return;
+
+	s = pg_round_down (obj);
+	ASSERT (s->arena.magic == ARENA_MAGIC);
+	ASSERT (s->arena.cache == c);
+	ASSERT (pg_ofs (obj) >= c->obj_ofs);
+	ASSERT ((pg_ofs (obj) - c->obj_ofs) % c->size == 0);
+	idx = (pg_ofs (obj) - c->obj_ofs) / c->size;
+	ASSERT (idx < c->objs_per_slab);
+
+#ifndef NDEBUG
+	/* Clear the object to help detect use-after-free bugs, unless
+	   it has to keep its constructed state. */
+	if (c->ctor == NULL)
+		memset (obj, 0xcc, c->size);
+#endif
+
+	lock_acquire (&c->lock);
+	ASSERT (s->arena.free_cnt < c->objs_per_slab);
+	if (s->arena.free_cnt == 0) {
+		list_remove (&s->elem);
+		list_push_front (&c->partial, &s->elem);
+	}
+	s->free_idx[s->arena.free_cnt++] = idx;
+	c->in_use--;
+
+	/* 다 빈 slab은 하나만 남겨두고 palloc에 돌려준다 */
+	if (s->arena.free_cnt == c->objs_per_slab) {
+		list_remove (&s->elem);
+		if (list_empty (&c->empty))
+			list_push_front (&c->empty, &s->elem);
+		else {
+			palloc_free_page (s);
+			c->slab_cnt--;
+			c->reap_cnt++;
+		}
+	}
+	lock_release (&c->lock);
+}
+
+/* Prints statistics for every object cache. */
+void
+kmem_cache_print_stats (void) {
+	struct list_elem *e;
+
+	lock_acquire (&caches_lock);
+	for (e = list_begin (&caches); e != list_end (&caches); e = list_next (e)) {
+		struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+
+		printf ("Cache %s: %zu-byte objects, %zu per slab, %zu slabs, "
+				"%zu in use, %lld allocs, %lld slabs created, %lld freed\n",
+				c->name, c->size, c->objs_per_slab, c->slab_cnt, c->in_use,
+				c->alloc_cnt, c->grow_cnt, c->reap_cnt);
+	}
+	lock_release (&caches_lock);
+}
+
+/* Allocates a new slab for cache C and constructs its objects.
+   Returns a null pointer if memory is not available.  C's lock
+   must be held. */
+static struct slab *
+slab_create (struct kmem_cache *c) {
+	struct slab *s;
+
+	ASSERT (lock_held_by_current_thread (&c->lock));
+
+	s = palloc_get_page (0);
+	if (s == NULL)
+		return NULL;
+
+	s->arena.magic = ARENA_MAGIC;
+	s->arena.desc = NULL;
+	s->arena.cache = c;
+	s->arena.free_cnt = c->objs_per_slab;
+	for (size_t i = 0; i < c->objs_per_slab; i++) {
+		/* Hand out low addresses first. */
+		s->free_idx[i] = c->objs_per_slab - 1 - i;
+		if (c->ctor != NULL)
+			c->ctor (slab_obj (c, s, i));
+	}
+	c->slab_cnt++;
+	c->grow_cnt++;
+	return s;
+}
+
+/* Returns the IDX'th object in slab S of cache C. */
+static void *
+slab_obj (struct kmem_cache *c, struct slab *s, size_t idx) {
+	ASSERT (idx < c->objs_per_slab);
+	return (uint8_t *) s + c->obj_ofs + idx * c->size;
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b) {
 	struct arena *a = pg_round_down (b);
+	struct arena *owner = palloc_get_owner (a);
+
+	/* Pages of a medium arena point to its first page. */
+	if (owner != NULL)
+		a = owner;
 
 	/* Check that the arena is valid. */
 	ASSERT (a != NULL);
 	ASSERT (a->magic == ARENA_MAGIC);
 
 	/* Check that the block is properly aligned for the arena. */
-	ASSERT (a->desc == NULL
-			|| (pg_ofs (b) - sizeof *a) % a->desc->block_size == 0);
-	ASSERT (a->desc != NULL || pg_ofs (b) == sizeof *a);
+	ASSERT (a->cache != NULL || a->desc == NULL
+			|| ((uint8_t *) b - (uint8_t *) a - sizeof *a)
+			   % a->desc->block_size == 0);
+	ASSERT (a->cache != NULL || a->desc != NULL || pg_ofs (b) == sizeof *a);
 
 	return a;
 }
@@ -8,9 +8,12 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "threads/workqueue.h"
 
 /* Page allocator.  Hands out memory in page-size (or
    page-multiple) chunks.  See malloc.h for an allocator that
@@ -24,13 +27,76 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is a binary buddy allocator.  Free memory is kept as
+   blocks of 2^ORDER pages whose index in the pool is a multiple
+   of 2^ORDER, one free list per order.  The list links live in
+   an array of `union page_meta' beside the used_map rather than
+   in the free pages themselves, which may not be mapped yet when
+   the pools are populated.  While a page is allocated, its entry
+   instead holds an owner pointer for the page's user, see
+   palloc_set_owner().  A request for N pages takes the smallest
+   free block of at least N pages, halving it as needed, and
+   gives back the tail beyond N.  A freed block merges with its
+   buddy, the other half of the block it was split from, for as
+   long as that buddy is free too.  Both are O(log n) in the pool
+   size, instead of a first-fit scan over the whole bitmap.
+
+   The pools are protected by a spinlock with interrupts off, so
+   that pages can be freed from the scheduler, which runs with
+   interrupts off.
+
+   Every pool also keeps a small stock of pages that are already
+   zeroed, so that a single-page PAL_ZERO request, as made by
+   thread creation, page table setup and fork, takes one off a
+   list instead of clearing 4 kB on the spot.  A work item on
+   the system workqueue, run at the lowest priority, tops the
+   stock up to the pool's high watermark whenever it falls below
+   the low one.  It clears pages with non-temporal stores, which
+   bypass the cache, so that it does not evict the working set of
+   the threads it runs between.  Zeroed pages count as used; a
+   pool that runs out of free blocks gives them back before
+   failing. */
+
+/* Largest block order: 2^MAX_ORDER pages. */
+#define MAX_ORDER 20
+
+/* Most zeroed pages kept per pool, and the fraction of the pool
+   that may be kept zeroed. */
+#define ZERO_HIGH 64
+#define ZERO_POOL_FRACTION 32
+
+/* Per-page metadata. */
+union page_meta {
+	struct list_elem free_elem;     /* Free list element, if a free
+	                                   block starts here. */
+	void *owner;                    /* If allocated: set by the owner. */
+};
 
 /* A memory pool. */
 struct pool {
-	struct lock lock;               /* Mutual exclusion. */
-	struct bitmap *used_map;        /* Bitmap of free pages. */
+	struct spinlock lock;           /* Mutual exclusion. */
+	struct bitmap *used_map;        /* Bitmap of used pages. */
+	uint8_t *order_map;             /* Per page: order + 1 if it starts a
+	                                   free block, otherwise 0. */
+	union page_meta *meta;          /* Per page metadata. */
+	struct list free_lists[MAX_ORDER + 1];  /* Free blocks per order. */
 	uint8_t *base;                  /* Base of pool. */
+	const char *name;               /* Name, for statistics. */
+
+	/* Zeroed pages, linked through their meta entries. */
+	struct list zero_list;          /* Pages ready for PAL_ZERO. */
+	size_t zero_cnt;                /* # of pages in zero_list. */
+	size_t zero_low, zero_high;     /* Watermarks for zero_work. */
+
+	/* Statistics. */
+	size_t free_cnt;                /* # of free pages. */
+	uint64_t split_cnt;             /* # of blocks split in two. */
+	uint64_t merge_cnt;             /* # of buddies merged. */
+	uint64_t zero_hit_cnt;          /* # of PAL_ZERO pages from zero_list. */
+	uint64_t zero_miss_cnt;         /* # of PAL_ZERO requests cleared inline. */
+	uint64_t zeroed_cnt;            /* # of pages cleared by zero_work. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -39,9 +105,20 @@ static struct pool kernel_pool, user_pool;
 /* Maximum number of pages to put in user pool. */
 size_t user_page_limit = SIZE_MAX;
 static void
-init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
-
-static bool page_from_pool (const struct pool *, void *page);
+init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end,
+		const char *name);
+
+static bool page_from_pool (const struct pool *, const void *page);
+static struct pool *pool_of (const void *page);
+static void pool_release (struct pool *, size_t page_idx, size_t page_cnt);
+static bool buddy_alloc (struct pool *, size_t page_cnt, size_t *page_idx);
+static void buddy_free_range (struct pool *, size_t page_idx, size_t page_cnt);
+static void buddy_carve (struct pool *, size_t page_idx, size_t page_cnt);
+static void pool_claim (struct pool *, size_t page_idx, size_t page_cnt);
+static void *zero_pop (struct pool *);
+static void zero_drain (struct pool *);
+static void zero_wake (void);
+static void zero_work_func (struct work *);
 
 /* multiboot info */
 struct multiboot_info {
@@ -159,7 +236,8 @@ populate_pools (struct area *base_mem, struct area *ext_mem) {
 					}
 					// generate kernel pool
 					init_pool (&kernel_pool,
-							&free_start, region_start, start + rem * PGSIZE);
+							&free_start, region_start, start + rem * PGSIZE,
+							"kernel_pool");
 					// Transition to the next state
 					if (rem == size_in_pg) {
 						rem = user_pages;
@@ -188,7 +266,7 @@ populate_pools (struct area *base_mem, struct area *ext_mem) {
 	}
 
 	// generate the user pool
-	init_pool(&user_pool, &free_start, region_start, end);
+	init_pool(&user_pool, &free_start, region_start, end, "user_pool");
 
 	// Iterate over the e820_entry. Setup the usable.
 	uint64_t usable_bound = (uint64_t) free_start;
@@ -223,12 +301,12 @@ split:
 			page_idx = pg_no (start) - pg_no (pool->base);
 			if ((uint64_t) pool_end < end) {
 				page_cnt = ((uint64_t) pool_end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool_release (pool, page_idx, page_cnt);
 				start = (uint64_t) pool_end;
 				goto split;
 			} else {
 				page_cnt = ((uint64_t) end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool_release (pool, page_idx, page_cnt);
 			}
 		}
 	}
@@ -262,16 +340,38 @@ palloc_init (void) {
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	enum intr_level old_level;
+	size_t page_idx;
+	void *pages = NULL;
+	bool wake;
+
+	old_level = intr_disable ();
+	spin_lock (&pool->lock);
+	if (page_cnt == 1 && (flags & PAL_ZERO) && pool->zero_cnt > 0) {
+		pages = zero_pop (pool);
+		pool->zero_hit_cnt++;
+		flags &= ~PAL_ZERO;
+	} else if (page_cnt > 0) {
+		bool found = buddy_alloc (pool, page_cnt, &page_idx);
+
+		/* free block이 모자라면 zero된 페이지들을 돌려주고 다시 시도 */
+		if (!found && pool->zero_cnt > 0) {
+			zero_drain (pool);
+			found = buddy_alloc (pool, page_cnt, &page_idx);
+		}
+		if (found) {
+			pool_claim (pool, page_idx, page_cnt);
+			pages = pool->base + PGSIZE * page_idx;
+		}
+		if (flags & PAL_ZERO)
+			pool->zero_miss_cnt++;
+	}
+	wake = pool->zero_cnt < pool->zero_low;
+	spin_unlock (&pool->lock);
+	intr_set_level (old_level);
 
-	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-	lock_release (&pool->lock);
-	void *pages;
-
-	if (page_idx != BITMAP_ERROR)
-		pages = pool->base + PGSIZE * page_idx;
-	else
-		pages = NULL;
+	if (wake)
+		zero_wake ();
 
 	if (pages) {
 		if (flags & PAL_ZERO)
@@ -300,26 +400,25 @@ palloc_get_page (enum palloc_flags flags) {
 void
 palloc_free_multiple (void *pages, size_t page_cnt) {
 	struct pool *pool;
+	enum intr_level old_level;
 	size_t page_idx;
 
 	ASSERT (pg_ofs (pages) == 0);
 	if (pages == NULL || page_cnt == 0)
 		return;
 
-	if (page_from_pool (&kernel_pool, pages))
-		pool = &kernel_pool;
-	else if (page_from_pool (&user_pool, pages))
-		pool = &user_pool;
-	else
-		NOT_REACHED ();
-
+	pool = pool_of (pages);
 	page_idx = pg_no (pages) - pg_no (pool->base);
 
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
+	old_level = intr_disable ();
+	spin_lock (&pool->lock);
 	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	pool_release (pool, page_idx, page_cnt);
+	spin_unlock (&pool->lock);
+	intr_set_level (old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -328,29 +427,392 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
-/* Initializes pool P as starting at START and ending at END */
+/* Work item that keeps the pools stocked with zeroed pages. */
+static struct work zero_work;
+static bool zero_started;
+
+/* Starts keeping the pools stocked with zeroed pages on the
+   system workqueue.  Must be called after workqueue_init(). */
+void
+palloc_zero_start (void) {
+	work_init (&zero_work, zero_work_func, PRI_MIN);
+	zero_started = true;
+	queue_work (system_wq, &zero_work);
+}
+
+/* Tries to grow the allocation of PAGE_CNT pages at PAGES to
+   NEW_PAGE_CNT pages in place, which is possible if the pages
+   that follow it are free.  Returns true if successful, false
+   otherwise. */
+bool
+palloc_extend (void *pages, size_t page_cnt, size_t new_page_cnt) {
+	struct pool *pool = pool_of (pages);
+	size_t page_idx = pg_no (pages) - pg_no (pool->base);
+	size_t extra = new_page_cnt - page_cnt;
+	enum intr_level old_level;
+	bool success = false;
+
+	ASSERT (pg_ofs (pages) == 0);
+	ASSERT (new_page_cnt >= page_cnt);
+
+	old_level = intr_disable ();
+	spin_lock (&pool->lock);
+	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
+	if (page_idx + new_page_cnt <= bitmap_size (pool->used_map)
+			&& bitmap_none (pool->used_map, page_idx + page_cnt, extra)) {
+		buddy_carve (pool, page_idx + page_cnt, extra);
+		pool_claim (pool, page_idx + page_cnt, extra);
+		success = true;
+	}
+	spin_unlock (&pool->lock);
+	intr_set_level (old_level);
+	return success;
+}
+
+/* Stores OWNER for the allocated page PAGE, for palloc_get_owner()
+   to return.  Freshly allocated pages have a null owner. */
+void
+palloc_set_owner (void *page, void *owner) {
+	struct pool *pool = pool_of (page);
+	size_t page_idx = pg_no (page) - pg_no (pool->base);
+
+	ASSERT (bitmap_test (pool->used_map, page_idx));
+	pool->meta[page_idx].owner = owner;
+}
+
+/* Returns the owner of the allocated page that contains ADDR, as
+   set by palloc_set_owner(). */
+void *
+palloc_get_owner (const void *addr) {
+	struct pool *pool = pool_of (addr);
+	size_t page_idx = pg_no (addr) - pg_no (pool->base);
+
+	ASSERT (bitmap_test (pool->used_map, page_idx));
+	return pool->meta[page_idx].owner;
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void) {
+	struct pool *pools[] = { &kernel_pool, &user_pool };
+
+	for (size_t i = 0; i < sizeof pools / sizeof *pools; i++) {
+		struct pool *p = pools[i];
+		enum intr_level old_level = intr_disable ();
+
+		spin_lock (&p->lock);
+		printf ("Palloc %s: %zu of %zu pages free, "
+				"%"PRIu64" splits, %"PRIu64" merges\n",
+				p->name, p->free_cnt, bitmap_size (p->used_map),
+				p->split_cnt, p->merge_cnt);
+		printf ("  zeroed pages: %zu ready, %"PRIu64" zeroed, "
+				"%"PRIu64" PAL_ZERO hits, %"PRIu64" misses\n",
+				p->zero_cnt, p->zeroed_cnt, p->zero_hit_cnt, p->zero_miss_cnt);
+		printf ("  free blocks by order:");
+		for (int order = 0; order <= MAX_ORDER; order++)
+			if (!list_empty (&p->free_lists[order]))
+				printf (" %d:%zu", order, list_size (&p->free_lists[order]));
+		printf ("\n");
+		spin_unlock (&p->lock);
+		intr_set_level (old_level);
+	}
+}
+
+/* Initializes pool P named NAME as starting at START and ending at END */
 static void
-init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
+init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end,
+		const char *name) {
+  /* We'll put the pool's used_map, order_map and meta at
+     BM_BASE.  Calculate the space needed for them and subtract
+     it from the pool's size. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
 	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t meta_pages = DIV_ROUND_UP (pgcnt * (sizeof *p->meta + 1),
+			PGSIZE) * PGSIZE;
 
-	lock_init(&p->lock);
+	spinlock_init (&p->lock);
 	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
+	p->meta = *bm_base + bm_pages;
+	p->order_map = (uint8_t *) (p->meta + pgcnt);
+	memset (p->order_map, 0, pgcnt);
+	for (int order = 0; order <= MAX_ORDER; order++)
+		list_init (&p->free_lists[order]);
 	p->base = (void *) start;
+	p->name = name;
+	list_init (&p->zero_list);
+	p->zero_cnt = 0;
+	p->zero_high = pgcnt / ZERO_POOL_FRACTION < ZERO_HIGH
+		? pgcnt / ZERO_POOL_FRACTION : ZERO_HIGH;
+	p->zero_low = p->zero_high / 4;
+	p->free_cnt = 0;
+	p->split_cnt = p->merge_cnt = 0;
+	p->zero_hit_cnt = p->zero_miss_cnt = p->zeroed_cnt = 0;
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
 
-	*bm_base += bm_pages;
+	*bm_base += bm_pages + meta_pages;
+}
+
+/* Marks the PAGE_CNT pages of P starting at PAGE_IDX, which the
+   buddy allocator has just handed out, used. */
+static void
+pool_claim (struct pool *p, size_t page_idx, size_t page_cnt) {
+	ASSERT (bitmap_none (p->used_map, page_idx, page_cnt));
+
+	bitmap_set_multiple (p->used_map, page_idx, page_cnt, true);
+	for (size_t i = page_idx; i < page_idx + page_cnt; i++)
+		p->meta[i].owner = NULL;
+	p->free_cnt -= page_cnt;
+}
+
+/* Marks the PAGE_CNT pages of P starting at PAGE_IDX free and
+   gives them to the buddy allocator. */
+static void
+pool_release (struct pool *p, size_t page_idx, size_t page_cnt) {
+	bitmap_set_multiple (p->used_map, page_idx, page_cnt, false);
+	buddy_free_range (p, page_idx, page_cnt);
+	p->free_cnt += page_cnt;
+}
+
+/* Puts the free block of 2^ORDER pages at PAGE_IDX on P's free
+   list for ORDER. */
+static void
+block_push (struct pool *p, size_t page_idx, int order) {
+	p->order_map[page_idx] = order + 1;
+	list_push_front (&p->free_lists[order], &p->meta[page_idx].free_elem);
+}
+
+/* Takes the free block at PAGE_IDX off P's free list for ORDER. */
+static void
+block_remove (struct pool *p, size_t page_idx, int order) {
+	ASSERT (p->order_map[page_idx] == order + 1);
+
+	p->order_map[page_idx] = 0;
+	list_remove (&p->meta[page_idx].free_elem);
+}
+
+/* Allocates PAGE_CNT contiguous pages from P and stores the
+   index of the first in *PAGE_IDX.  Returns false if no free
+   block is large enough. */
+static bool
+buddy_alloc (struct pool *p, size_t page_cnt, size_t *page_idx) {
+	int order = 0, found;
+	size_t idx;
+
+	while (((size_t) 1 << order) < page_cnt)
+		if (++order > MAX_ORDER)
+			return false;
+
+	for (found = order; found <= MAX_ORDER; found++)
+		if (!list_empty (&p->free_lists[found]))
+			break;
+	if (found > MAX_ORDER)
+		return false;
+
+	idx = list_entry (list_front (&p->free_lists[found]),
+			union page_meta, free_elem) - p->meta;
+	block_remove (p, idx, found);
+
+	/* 앞쪽 절반을 남기고 뒤쪽 절반은 free list로 돌려주면서 쪼갠다 */
+	while (found > order) {
+		found--;
+		block_push (p, idx + ((size_t) 1 << found), found);
+		p->split_cnt++;
+	}
+
+	/* 2^ORDER 중 PAGE_CNT를 넘는 꼬리는 바로 돌려준다 */
+	buddy_free_range (p, idx + page_cnt, ((size_t) 1 << order) - page_cnt);
+
+	*page_idx = idx;
+	return true;
+}
+
+/* Frees the block of 2^ORDER pages at PAGE_IDX in P, merging it
+   with its buddy for as long as the buddy is a free block of the
+   same order. */
+static void
+buddy_free (struct pool *p, size_t page_idx, int order) {
+	size_t pgcnt = bitmap_size (p->used_map);
+
+	while (order < MAX_ORDER) {
+		size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+		if (buddy >= pgcnt || p->order_map[buddy] != order + 1)
+			break;
+		block_remove (p, buddy, order);
+		p->merge_cnt++;
+		page_idx &= ~((size_t) 1 << order);
+		order++;
+	}
+	block_push (p, page_idx, order);
+}
+
+/* Frees the PAGE_CNT pages of P starting at PAGE_IDX, as the
+   fewest aligned power-of-two blocks that cover them. */
+static void
+buddy_free_range (struct pool *p, size_t page_idx, size_t page_cnt) {
+	while (page_cnt > 0) {
+		int order = 0;
+
+		while (order < MAX_ORDER
+				&& (page_idx & ((size_t) 1 << order)) == 0
+				&& ((size_t) 2 << order) <= page_cnt)
+			order++;
+		buddy_free (p, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
+
+/* Takes the free pages PAGE_IDX...PAGE_IDX + PAGE_CNT - 1 of P
+   out of the buddy allocator, splitting the free blocks that hold
+   them and giving back the parts outside the range. */
+static void
+buddy_carve (struct pool *p, size_t page_idx, size_t page_cnt) {
+	size_t end = page_idx + page_cnt;
+
+	while (page_idx < end) {
+		size_t head, block_end;
+		int order;
+
+		/* PAGE_IDX를 포함하는 free block의 시작은 PAGE_IDX를
+		   2^ORDER 단위로 내림한 위치 중 하나다 */
+		for (order = 0; ; order++) {
+			ASSERT (order <= MAX_ORDER);
+			head = page_idx & ~(((size_t) 1 << order) - 1);
+			if (p->order_map[head] == order + 1)
+				break;
+		}
+		block_end = head + ((size_t) 1 << order);
+		block_remove (p, head, order);
+		p->split_cnt++;
+
+		buddy_free_range (p, head, page_idx - head);
+		if (block_end > end) {
+			buddy_free_range (p, end, block_end - end);
+			block_end = end;
+		}
+		page_idx = block_end;
+	}
+}
+
+/* Takes a page off P's zeroed page list and returns it.  P's
+   lock must be held. */
+static void *
+zero_pop (struct pool *p) {
+	size_t page_idx;
+
+	ASSERT (p->zero_cnt > 0);
+
+	page_idx = list_entry (list_pop_front (&p->zero_list),
+			union page_meta, free_elem) - p->meta;
+	p->meta[page_idx].owner = NULL;
+	p->zero_cnt--;
+	return p->base + PGSIZE * page_idx;
+}
+
+/* Gives all of P's zeroed pages back to the buddy allocator.  P's
+   lock must be held. */
+static void
+zero_drain (struct pool *p) {
+	while (p->zero_cnt > 0) {
+		void *page = zero_pop (p);
+
+		pool_release (p, pg_no (page) - pg_no (p->base), 1);
+	}
+}
+
+/* Clears PAGE with non-temporal stores, which go to memory
+   without filling the cache. */
+static void
+zero_page_nt (void *page) {
+	uint64_t *p = page;
+
+	for (size_t i = 0; i < PGSIZE / sizeof *p; i += 4)
+		asm volatile ("movnti %1, (%0)\n\t"
+		              "movnti %1, 8(%0)\n\t"
+		              "movnti %1, 16(%0)\n\t"
+		              "movnti %1, 24(%0)"
+		              : : "r" (p + i), "r" (0UL) : "memory");
+
+	/* Non-temporal stores are weakly ordered: make them visible
+	   before the page is handed out. */
+	asm volatile ("sfence" : : : "memory");
+}
+
+/* Zeroes free pages of P until it holds zero_high of them or it
+   runs out of free pages. */
+static void
+zero_fill (struct pool *p) {
+	for (;;) {
+		enum intr_level old_level;
+		size_t page_idx;
+		bool found;
+
+		old_level = intr_disable ();
+		spin_lock (&p->lock);
+		found = p->zero_cnt < p->zero_high && buddy_alloc (p, 1, &page_idx);
+		if (found)
+			pool_claim (p, page_idx, 1);
+		spin_unlock (&p->lock);
+		intr_set_level (old_level);
+		if (!found)
+			return;
+
+		/* 페이지를 지우는 동안에는 lock을 잡지 않는다 */
+		zero_page_nt (p->base + PGSIZE * page_idx);
+
+		old_level = intr_disable ();
+		spin_lock (&p->lock);
+		list_push_back (&p->zero_list, &p->meta[page_idx].free_elem);
+		p->zero_cnt++;
+		p->zeroed_cnt++;
+		spin_unlock (&p->lock);
+		intr_set_level (old_level);
+	}
+}
+
+/* Queues zero_work, unless it is already pending or the
+   workqueue is not up yet. */
+static void
+zero_wake (void) {
+	if (zero_started)
+		queue_work (system_wq, &zero_work);
+}
+
+/* zero_work의 본체.
+	두 pool의 zero된 페이지를 high watermark까지 채운다.
+	palloc_get_multiple()이 low watermark 아래로 떨어진 것을 보면
+	zero_wake()로 다시 queue한다. work의 priority는 PRI_MIN이고,
+	priority를 쓰지 않는 스케줄러에서는 그동안 worker의 nice를 올린다. */
+static void
+zero_work_func (struct work *work UNUSED) {
+	int nice = thread_get_nice ();
+
+	if (thread_mlfqs || thread_cfs)
+		thread_set_nice (NICE_MAX);
+	zero_fill (&kernel_pool);
+	zero_fill (&user_pool);
+	if (thread_mlfqs || thread_cfs)
+		thread_set_nice (nice);
+}
+
+/* Returns the pool that PAGE belongs to. */
+static struct pool *
+pool_of (const void *page) {
+	if (page_from_pool (&kernel_pool, page))
+		return &kernel_pool;
+	else if (page_from_pool (&user_pool, page))
+		return &user_pool;
+	else
+		NOT_REACHED ();
 }
 
 /* Returns true if PAGE was allocated from POOL,
    false otherwise. */
 static bool
-page_from_pool (const struct pool *pool, void *page) {
+page_from_pool (const struct pool *pool, const void *page) {
 	size_t page_no = pg_no (page);
 	size_t start_page = pg_no (pool->base);
 	size_t end_page = start_page + bitmap_size (pool->used_map);
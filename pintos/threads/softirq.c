@@ -0,0 +1,173 @@
+#include "threads/softirq.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sched.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* All of the state below is protected by disabling interrupts.
+   `busy' keeps handlers from running twice at once: when an
+   interrupt arrives while the interrupted thread is already
+   running softirqs at the end of an earlier interrupt, the new
+   one only raises its softirq and leaves it to the outer loop. */
+
+/* 한 번 실행할 때 pending을 다시 확인하는 최대 횟수.
+   이것보다 많이 다시 raise 되면 나머지는 ksoftirqd에게 넘긴다. */
+#define SOFTIRQ_RESTART 10
+
+/* A registered softirq. */
+struct softirq_action {
+	softirq_func *func;         /* Handler. */
+	void *aux;                  /* Argument for FUNC. */
+	long long cnt;              /* # of times FUNC ran. */
+};
+
+static struct softirq_action actions[SOFTIRQ_CNT];
+static uint32_t pending;        /* Bit N set if softirq N is raised. */
+static bool busy;               /* Some thread is running handlers. */
+static bool in_tail;            /* ...at the end of intr_handler()? */
+
+static struct thread *ksoftirqd_thread;
+static bool ksoftirqd_sleeping; /* Blocked waiting for work? */
+static long long deferred_cnt;  /* # of times work went to ksoftirqd. */
+
+static void softirq_do (void);
+static void ksoftirqd_wake (void);
+static void ksoftirqd (void *aux);
+
+/* Makes FUNC(AUX) the handler of softirq NR. */
+void
+softirq_register (enum softirq nr, softirq_func *func, void *aux) {
+	ASSERT (nr < SOFTIRQ_CNT);
+	ASSERT (func != NULL);
+	ASSERT (actions[nr].func == NULL);
+
+	actions[nr].func = func;
+	actions[nr].aux = aux;
+}
+
+/* Marks softirq NR pending.  Usually called from an interrupt
+   handler, in which case it runs when the handler returns.
+   Outside an interrupt handler, ksoftirqd is woken to run it. */
+void
+softirq_raise (enum softirq nr) {
+	enum intr_level old_level;
+
+	ASSERT (nr < SOFTIRQ_CNT);
+	ASSERT (actions[nr].func != NULL);
+
+	old_level = intr_disable ();
+	pending |= 1u << nr;
+	if (!intr_context () && !busy)
+		ksoftirqd_wake ();
+	intr_set_level (old_level);
+}
+
+/* Runs the pending softirqs.  Called by intr_handler() with
+   interrupts off after an external interrupt has been
+   acknowledged. */
+void
+softirq_run (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (!intr_context ());
+
+	if (pending == 0 || busy)
+		return;
+
+	busy = in_tail = true;
+	softirq_do ();
+	if (pending != 0) {
+		deferred_cnt++;
+		ksoftirqd_wake ();
+	}
+	busy = in_tail = false;
+}
+
+/* Starts ksoftirqd.  Must be called after thread_start().
+   Until then, softirqs left over by softirq_run() wait for the
+   next interrupt. */
+void
+softirq_start (void) {
+	tid_t tid = thread_create ("ksoftirqd", PRI_MAX, ksoftirqd, NULL);
+
+	if (tid == TID_ERROR)
+		PANIC ("could not create ksoftirqd");
+}
+
+/* Returns true while softirq handlers run at the end of an
+   interrupt.  They run on the interrupted thread's stack and
+   must not switch threads, so thread_maybe_yield() and
+   intr_yield_on_return() use the interrupt's yield instead. */
+bool
+softirq_context (void) {
+	return in_tail;
+}
+
+/* Prints softirq statistics. */
+void
+softirq_print_stats (void) {
+	printf ("Softirq: %lld timer, %lld block, %lld deferred to ksoftirqd\n",
+			actions[SOFTIRQ_TIMER].cnt, actions[SOFTIRQ_BLOCK].cnt,
+			deferred_cnt);
+}
+
+/* Runs pending softirqs, with interrupts enabled, until none
+   are pending or SOFTIRQ_RESTART rounds have passed.  Must be
+   called with interrupts off and `busy' set. */
+static void
+softirq_do (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (busy);
+
+	for (int round = 0; pending != 0 && round < SOFTIRQ_RESTART; round++) {
+		uint32_t work = pending;
+
+		pending = 0;
+		intr_enable ();
+		while (work != 0) {
+			struct softirq_action *a = &actions[__builtin_ctz (work)];
+
+			work &= work - 1;
+			a->func (a->aux);
+			a->cnt++;
+		}
+		intr_disable ();
+	}
+}
+
+/* Unblocks ksoftirqd if it is waiting for work.  Interrupts
+   must be off. */
+static void
+ksoftirqd_wake (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (ksoftirqd_thread != NULL && ksoftirqd_sleeping) {
+		ksoftirqd_sleeping = false;
+		thread_unblock (ksoftirqd_thread);
+		thread_maybe_yield ();
+	}
+}
+
+/* ksoftirqd 스레드의 본체.
+	인터럽트 끝에서 다 처리하지 못한 softirq를 처리하고,
+	남은 일이 없으면 block 해서 ksoftirqd_wake를 기다린다.
+	다른 일반 스레드보다 먼저 실행되도록 SCHED_FIFO로 돈다. */
+static void
+ksoftirqd (void *aux UNUSED) {
+	thread_set_scheduler (SCHED_FIFO, SCHED_RT_PRIO_MAX);
+
+	intr_disable ();
+	ksoftirqd_thread = thread_current ();
+	for (;;) {
+		if (pending == 0 || busy) {
+			ksoftirqd_sleeping = true;
+			thread_block ();
+			continue;
+		}
+		busy = true;
+		softirq_do ();
+		busy = false;
+	}
+}
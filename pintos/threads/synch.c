@@ -27,10 +27,72 @@
    */
 
 #include "threads/synch.h"
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Initializes spinlock SL. */
+void
+spinlock_init (struct spinlock *sl) {
+	ASSERT (sl != NULL);
+
+	sl->locked = 0;
+}
+
+/* Acquires spinlock SL, spinning until it becomes available.
+   Interrupts must be off, so that the holder cannot be preempted
+   on this CPU. */
+void
+spin_lock (struct spinlock *sl) {
+	ASSERT (sl != NULL);
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (__sync_lock_test_and_set (&sl->locked, 1))
+		while (sl->locked)
+			asm volatile ("pause");
+}
+
+/* Releases spinlock SL. */
+void
+spin_unlock (struct spinlock *sl) {
+	ASSERT (sl != NULL);
+	ASSERT (sl->locked);
+
+	__sync_lock_release (&sl->locked);
+}
+
+/* Order of arrival at a wait queue, so that waiters of equal
+   priority are woken first come, first served. */
+static uint64_t wait_seq_next;
+
+/* semaphore waiters heap의 비교 함수
+	priority가 같으면 먼저 기다리기 시작한 스레드가 더 크다 */
+static bool
+waiter_less (const struct pheap_elem *a_, const struct pheap_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = pheap_entry (a_, struct thread, wait_elem);
+	const struct thread *b = pheap_entry (b_, struct thread, wait_elem);
+
+	if (a->priority != b->priority)
+		return a->priority < b->priority;
+	return a->wait_seq > b->wait_seq;
+}
+
+/* 현재 스레드를 SEMA의 waiters에 넣는 함수.
+	SEMA의 spinlock을 잡은 상태에서 호출해야 한다. */
+static void
+sema_enqueue (struct semaphore *sema) {
+	struct thread *cur = thread_current ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	cur->wait_sema = sema;
+	cur->wait_seq = wait_seq_next++;
+	pheap_push (&sema->waiters, &cur->wait_elem);
+}
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -45,8 +107,9 @@ void
 sema_init (struct semaphore *sema, unsigned value) {
 	ASSERT (sema != NULL);
 
+	spinlock_init (&sema->lock);
 	sema->value = value;
-	list_init (&sema->waiters);
+	pheap_init (&sema->waiters, waiter_less, NULL);
 }
 
 /* list_insert_ordered 함수에서 사용하기 위한 함수
@@ -77,11 +140,71 @@ sema_down (struct semaphore *sema) {
 	ASSERT (!intr_context ());
 
 	old_level = intr_disable ();
+	spin_lock (&sema->lock);
 	while (sema->value == 0) {
-		list_insert_ordered (&sema->waiters, &thread_current ()->elem, prior_priority, NULL);
-		thread_block ();
+		sema_enqueue (sema);
+		thread_block_locked (&sema->lock);
+		spin_lock (&sema->lock);
 	}
 	sema->value--;
+	spin_unlock (&sema->lock);
+	intr_set_level (old_level);
+}
+
+/* Like sema_down(), but gives up waiting once sema_kill() has
+   been called on the current thread, whether before or during
+   the wait.  Returns true if SEMA was decremented, false if the
+   thread was killed first.
+
+   This is meant for waits that may last forever, such as for a
+   child process, so that a dying process can still be torn
+   down. */
+bool
+sema_down_killable (struct semaphore *sema) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+	bool success = false;
+
+	ASSERT (sema != NULL);
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	spin_lock (&sema->lock);
+	while (sema->value == 0 && !cur->killed) {
+		sema_enqueue (sema);
+		cur->wait_killable = true;
+		thread_block_locked (&sema->lock);
+		spin_lock (&sema->lock);
+		cur->wait_killable = false;
+	}
+	if (sema->value > 0) {
+		sema->value--;
+		success = true;
+	}
+	spin_unlock (&sema->lock);
+	intr_set_level (old_level);
+	return success;
+}
+
+/* Marks T as killed, and wakes it up if it is asleep in
+   sema_down_killable(), which then returns false.  T's later
+   calls to sema_down_killable() return at once.  Waits in plain
+   sema_down() are not affected. */
+void
+sema_kill (struct thread *t) {
+	enum intr_level old_level = intr_disable ();
+	struct semaphore *sema = t->wait_sema;
+
+	t->killed = true;
+	if (sema != NULL && t->wait_killable) {
+		spin_lock (&sema->lock);
+		if (t->wait_sema == sema) {
+			pheap_remove (&sema->waiters, &t->wait_elem);
+			t->wait_sema = NULL;
+			thread_unblock (t);
+		}
+		spin_unlock (&sema->lock);
+	}
 	intr_set_level (old_level);
 }
 
@@ -98,6 +221,7 @@ sema_try_down (struct semaphore *sema) {
 	ASSERT (sema != NULL);
 
 	old_level = intr_disable ();
+	spin_lock (&sema->lock);
 	if (sema->value > 0)
 	{
 		sema->value--;
@@ -105,6 +229,7 @@ sema_try_down (struct semaphore *sema) {
 	}
 	else
 		success = false;
+	spin_unlock (&sema->lock);
 	intr_set_level (old_level);
 
 	return success;
@@ -121,14 +246,32 @@ sema_up (struct semaphore *sema) {
 	ASSERT (sema != NULL);
 
 	old_level = intr_disable ();
-	if (!list_empty (&sema->waiters))
-		thread_unblock (list_entry (list_pop_front (&sema->waiters),
-					struct thread, elem));
-   sema->value++;
-   thread_maybe_yield();
+	spin_lock (&sema->lock);
+	if (!pheap_empty (&sema->waiters)) {
+		/* 기다리는 동안 priority가 바뀌면 synch_requeue가 heap 안의
+		   위치를 고쳐 두므로 top이 지금 가장 높은 스레드다. */
+		struct thread *t = pheap_entry (pheap_pop (&sema->waiters),
+				struct thread, wait_elem);
+		t->wait_sema = NULL;
+		thread_unblock (t);
+	}
+	sema->value++;
+	spin_unlock (&sema->lock);
+	thread_maybe_yield();
 	intr_set_level (old_level);
 }
 
+/* SEMA의 waiters에 현재 스레드를 넣고 잠드는 함수.
+   interrupt가 꺼진 상태에서 호출해야 한다. */
+static void
+sema_block (struct semaphore *sema) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spin_lock (&sema->lock);
+	sema_enqueue (sema);
+	thread_block_locked (&sema->lock);
+}
+
 static void sema_test_helper (void *sema_);
 
 /* Self-test for semaphores that makes control "ping-pong"
@@ -164,6 +307,166 @@ sema_test_helper (void *sema_) {
 	}
 }
 
+/* Maximum depth of nested priority donation. */
+int lock_donate_depth = 8;
+
+static void rwlock_donate (struct rwlock *, int priority, int depth);
+static void rwlock_redonate (struct rwlock *, int depth);
+
+/* 기부받는 것이 바뀐 스레드 T의 priority를 다시 계산하고,
+   T가 다른 lock을 기다리고 있으면 그 holder에게도 차례로
+   기부하는 함수. 최대 DEPTH 단계까지만 따라가고,
+   priority가 더 이상 바뀌지 않는 단계에서 멈춘다. */
+static void
+donate_chain (struct thread *t, int depth) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (; depth > 0; depth--) {
+		struct thread *holder;
+
+		if (!thread_refresh_priority (t))
+			break;
+		if (t->wait_on_rwlock != NULL) {
+			/* T의 priority는 올라갔을 수도 내려갔을 수도 있으므로
+			   rwlock의 기부를 waiter들로 다시 계산한다. */
+			rwlock_redonate (t->wait_on_rwlock, depth - 1);
+			break;
+		}
+		if (t->wait_on_lock == NULL)
+			break;
+		holder = t->wait_on_lock->holder;
+		if (holder == NULL)
+			break;
+		/* T의 priority가 바뀌었으니 holder의 heap에서 위치를 고친다. */
+		pheap_update (&holder->donors, &t->donor_elem);
+		t = holder;
+	}
+}
+
+/* 현재 스레드가 LOCK을 기다리기 시작할 때 LOCK의 holder에게
+   priority를 기부하는 함수. */
+static void
+lock_donate (struct lock *lock) {
+	struct thread *cur = thread_current ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (lock->holder != NULL);
+
+	cur->wait_on_lock = lock;
+	pheap_push (&lock->holder->donors, &cur->donor_elem);
+	donate_chain (lock->holder, lock_donate_depth);
+}
+
+/* pheap_for_each로 lock waiter E의 기부를 DONORS에 넣는 함수 */
+static void
+donor_push (struct pheap_elem *e, void *donors) {
+	pheap_push (donors, &pheap_entry (e, struct thread, wait_elem)->donor_elem);
+}
+
+/* pheap_for_each로 lock waiter E의 기부를 DONORS에서 빼는 함수 */
+static void
+donor_remove (struct pheap_elem *e, void *donors) {
+	pheap_remove (donors, &pheap_entry (e, struct thread, wait_elem)->donor_elem);
+}
+
+/* 현재 스레드가 LOCK을 얻었을 때, 아직 LOCK을 기다리는 스레드들의
+   기부를 새 holder인 현재 스레드가 넘겨받는 함수 */
+static void
+lock_take_donors (struct lock *lock) {
+	struct thread *cur = thread_current ();
+	struct semaphore *sema = &lock->semaphore;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spin_lock (&sema->lock);
+	pheap_for_each (&sema->waiters, donor_push, &cur->donors);
+	spin_unlock (&sema->lock);
+	thread_refresh_priority (cur);
+}
+
+/* 현재 스레드가 LOCK을 놓을 때 LOCK을 기다리는 스레드들의 기부를
+   회수하는 함수. 남은 donors 중 가장 높은 값으로 priority가 돌아간다. */
+static void
+lock_drop_donors (struct lock *lock) {
+	struct thread *cur = thread_current ();
+	struct semaphore *sema = &lock->semaphore;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spin_lock (&sema->lock);
+	pheap_for_each (&sema->waiters, donor_remove, &cur->donors);
+	spin_unlock (&sema->lock);
+	thread_refresh_priority (cur);
+}
+
+#ifdef LOCKSTAT
+/* Lock contention statistics, one entry per lock name. */
+#define LOCKSTAT_MAX 64
+static struct lockstat lock_stats[LOCKSTAT_MAX];
+static size_t lock_stat_cnt;
+
+/* NAME의 통계 항목을 찾아 반환하고, 없으면 새로 만드는 함수.
+   표가 가득 찼으면 null을 반환하여 그 lock은 기록하지 않는다. */
+static struct lockstat *
+lock_stat_lookup (const char *name) {
+	struct lockstat *st;
+	size_t i;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (i = 0; i < lock_stat_cnt; i++)
+		if (!strcmp (lock_stats[i].name, name))
+			return &lock_stats[i];
+	if (lock_stat_cnt >= LOCKSTAT_MAX)
+		return NULL;
+
+	st = &lock_stats[lock_stat_cnt++];
+	memset (st, 0, sizeof *st);
+	strlcpy (st->name, name, sizeof st->name);
+	return st;
+}
+#endif
+
+/* Records that the current thread just got LOCK after starting
+   to wait at timer tick WAIT_START.  CONTENDED tells whether it
+   had to sleep.  Interrupts must be off. */
+static void
+lock_stat_acquired (struct lock *lock UNUSED, int64_t wait_start UNUSED,
+		bool contended UNUSED) {
+#ifdef LOCKSTAT
+	struct lockstat *st = lock->stat;
+	int64_t now = timer_ticks ();
+	uint64_t wait = now - wait_start;
+
+	lock->acquire_time = now;
+	if (st == NULL)
+		return;
+	st->acquired++;
+	if (contended)
+		st->contended++;
+	st->wait_ticks += wait;
+	if (wait > st->max_wait_ticks)
+		st->max_wait_ticks = wait;
+#endif
+}
+
+/* Records that the current thread is about to release LOCK.
+   Interrupts must be off. */
+static void
+lock_stat_released (struct lock *lock UNUSED) {
+#ifdef LOCKSTAT
+	struct lockstat *st = lock->stat;
+	uint64_t hold;
+
+	if (st == NULL)
+		return;
+	hold = timer_ticks () - lock->acquire_time;
+	st->hold_ticks += hold;
+	if (hold > st->max_hold_ticks)
+		st->max_hold_ticks = hold;
+#endif
+}
+
 /* Initializes LOCK.  A lock can be held by at most a single
    thread at any given time.  Our locks are not "recursive", that
    is, it is an error for the thread currently holding a lock to
@@ -185,24 +488,67 @@ lock_init (struct lock *lock) {
 
 	lock->holder = NULL;
 	sema_init (&lock->semaphore, 1);
+#ifdef LOCKSTAT
+	lock->stat = NULL;
+	lock->acquire_time = 0;
+#endif
+}
+
+/* Initializes LOCK like lock_init(), and names it NAME for the
+   lock contention statistics.  Locks with the same name share
+   their statistics.  NAME is copied, and is ignored unless the
+   kernel is built with LOCKSTAT. */
+void
+lock_init_named (struct lock *lock, const char *name UNUSED) {
+	lock_init (lock);
+#ifdef LOCKSTAT
+	enum intr_level old_level = intr_disable ();
+	lock->stat = lock_stat_lookup (name);
+	intr_set_level (old_level);
+#endif
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
    necessary.  The lock must not already be held by the current
    thread.
 
+   While waiting, the current thread donates its priority to the
+   holder, and through it to any chain of holders, so that a
+   low-priority holder cannot be starved by medium-priority
+   threads.  Every thread on the lock's wait list is in the
+   holder's donors heap; to keep that true, taking the semaphore
+   and setting the holder happen with interrupts off.
+
    This function may sleep, so it must not be called within an
    interrupt handler.  This function may be called with
    interrupts disabled, but interrupts will be turned back on if
    we need to sleep. */
 void
 lock_acquire (struct lock *lock) {
+	enum intr_level old_level;
+	int64_t wait_start = 0;
+	bool contended = false;
+
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (!lock_held_by_current_thread (lock));
 
-	sema_down (&lock->semaphore);
+#ifdef LOCKSTAT
+	wait_start = timer_ticks ();
+#endif
+	old_level = intr_disable ();
+	while (!sema_try_down (&lock->semaphore)) {
+		contended = true;
+		if (!thread_mlfqs)
+			lock_donate (lock);
+		sema_block (&lock->semaphore);
+	}
+	thread_current ()->wait_on_lock = NULL;
 	lock->holder = thread_current ();
+	if (!thread_mlfqs)
+		lock_take_donors (lock);
+	lock_stat_acquired (lock, wait_start, contended);
+	intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -213,14 +559,25 @@ lock_acquire (struct lock *lock) {
    interrupt handler. */
 bool
 lock_try_acquire (struct lock *lock) {
+	enum intr_level old_level;
+	int64_t wait_start = 0;
 	bool success;
 
 	ASSERT (lock != NULL);
 	ASSERT (!lock_held_by_current_thread (lock));
 
+#ifdef LOCKSTAT
+	wait_start = timer_ticks ();
+#endif
+	old_level = intr_disable ();
 	success = sema_try_down (&lock->semaphore);
-	if (success)
+	if (success) {
 		lock->holder = thread_current ();
+		if (!thread_mlfqs)
+			lock_take_donors (lock);
+		lock_stat_acquired (lock, wait_start, false);
+	}
+	intr_set_level (old_level);
 	return success;
 }
 
@@ -232,11 +589,18 @@ lock_try_acquire (struct lock *lock) {
    handler. */
 void
 lock_release (struct lock *lock) {
+	enum intr_level old_level;
+
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
 
+	old_level = intr_disable ();
+	lock_stat_released (lock);
+	if (!thread_mlfqs)
+		lock_drop_donors (lock);
 	lock->holder = NULL;
 	sema_up (&lock->semaphore);
+	intr_set_level (old_level);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -249,13 +613,380 @@ lock_held_by_current_thread (const struct lock *lock) {
 	return lock->holder == thread_current ();
 }
 
-/* One semaphore in a list. */
+/* Copies the statistics of the IDX'th named lock into ST.
+   Returns false if there is no such lock, which is always the
+   case unless the kernel is built with LOCKSTAT. */
+bool
+lock_stat_get (size_t idx UNUSED, struct lockstat *st UNUSED) {
+#ifdef LOCKSTAT
+	enum intr_level old_level;
+	bool found;
+
+	old_level = intr_disable ();
+	found = idx < lock_stat_cnt;
+	if (found)
+		*st = lock_stats[idx];
+	intr_set_level (old_level);
+	return found;
+#else
+	return false;
+#endif
+}
+
+/* Prints lock contention statistics. */
+void
+lock_print_stats (void) {
+	struct lockstat st;
+	size_t i;
+
+	for (i = 0; lock_stat_get (i, &st); i++)
+		printf ("Lock %s: %"PRIu64" acquires, %"PRIu64" contended, "
+				"%"PRIu64" wait ticks (max %"PRIu64"), "
+				"%"PRIu64" hold ticks (max %"PRIu64")\n",
+				st.name, st.acquired, st.contended,
+				st.wait_ticks, st.max_wait_ticks,
+				st.hold_ticks, st.max_hold_ticks);
+}
+
+/* Initializes RW.  A reader-writer lock may be held by any
+   number of readers at once, or by a single writer.
+
+   Writers are preferred: once a writer waits, new readers wait
+   too, so a steady stream of readers cannot starve writers.
+   Like locks, rwlocks are not recursive, and a thread may hold
+   at most RW_HOLD_MAX of them at once.
+
+   Threads waiting for a rwlock donate their priority to every
+   thread holding it, readers included.  Rwlocks are built
+   directly on thread_block() rather than on semaphores, so all
+   of their state is protected by disabling interrupts. */
+void
+rwlock_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	rw->writer = NULL;
+	rw->readers = 0;
+	rw->upgrader = NULL;
+	list_init (&rw->holders);
+	list_init (&rw->read_waiters);
+	list_init (&rw->write_waiters);
+	rw->donation = PRI_MIN;
+}
+
+/* 현재 스레드가 RW를 보유하고 있으면 그 rw_hold를, 아니면 null을
+   반환하는 함수 */
+static struct rw_hold *
+rwlock_find_hold (const struct rwlock *rw) {
+	struct thread *cur = thread_current ();
+
+	for (int i = 0; i < RW_HOLD_MAX; i++)
+		if (cur->rw_holds[i].lock == rw)
+			return &cur->rw_holds[i];
+	return NULL;
+}
+
+/* 현재 스레드를 RW의 holder로 등록하는 함수.
+   lock이 null인 빈 rw_hold를 찾아서 사용한다. */
+static void
+rwlock_hold (struct rwlock *rw) {
+	struct thread *cur = thread_current ();
+	struct rw_hold *h = rwlock_find_hold (NULL);
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	if (h == NULL)
+		PANIC ("%s: holds more than %d rwlocks", cur->name, RW_HOLD_MAX);
+
+	h->lock = rw;
+	h->thread = cur;
+	list_push_back (&rw->holders, &h->elem);
+}
+
+/* 현재 스레드를 RW의 holder에서 빼고, RW의 waiter들에게서 받던
+   기부를 회수하는 함수 */
+static void
+rwlock_unhold (struct rwlock *rw) {
+	struct rw_hold *h = rwlock_find_hold (rw);
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (h != NULL);
+
+	list_remove (&h->elem);
+	h->lock = NULL;
+	thread_refresh_priority (thread_current ());
+}
+
+/* 새 waiter의 PRIORITY를 RW의 모든 holder에게 기부하는 함수 */
+static void
+rwlock_donate (struct rwlock *rw, int priority, int depth) {
+	struct list_elem *e;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (priority <= rw->donation)
+		return;
+	rw->donation = priority;
+	for (e = list_begin (&rw->holders); e != list_end (&rw->holders);
+			e = list_next (e))
+		donate_chain (list_entry (e, struct rw_hold, elem)->thread, depth);
+}
+
+/* RW의 donation을 남은 waiter들로 다시 계산하고, 바뀐 기부를
+   holder들에게, 그리고 holder가 기다리는 lock의 holder들에게
+   DEPTH 단계까지 전달하는 함수. donation이 내려가는 경우도
+   lock_release처럼 chain을 따라 내려간다. */
+static void
+rwlock_redonate (struct rwlock *rw, int depth) {
+	struct list *lists[] = { &rw->read_waiters, &rw->write_waiters };
+	struct list_elem *e;
+	int donation = PRI_MIN;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (size_t i = 0; i < sizeof lists / sizeof *lists; i++)
+		for (e = list_begin (lists[i]); e != list_end (lists[i]); e = list_next (e)) {
+			struct thread *t = list_entry (e, struct thread, elem);
+			if (t->priority > donation)
+				donation = t->priority;
+		}
+	if (rw->upgrader != NULL && rw->upgrader->priority > donation)
+		donation = rw->upgrader->priority;
+	rw->donation = donation;
+
+	/* holder가 다른 lock을 기다리고 있으면 donate_chain이 그 lock
+	   holder의 donors heap에서 위치를 고치고 계속 따라간다. */
+	for (e = list_begin (&rw->holders); e != list_end (&rw->holders);
+			e = list_next (e))
+		donate_chain (list_entry (e, struct rw_hold, elem)->thread, depth);
+}
+
+/* waiter나 holder가 바뀐 뒤 RW의 donation을 다시 계산하는 함수 */
+static void
+rwlock_settle (struct rwlock *rw) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (thread_mlfqs)
+		return;
+	rwlock_redonate (rw, lock_donate_depth);
+}
+
+/* 현재 스레드를 RW의 WAITERS에 넣고 잠드는 함수.
+   깨워질 때 WAITERS에서는 깨운 쪽이 빼준다. */
+static void
+rwlock_wait (struct rwlock *rw, struct list *waiters) {
+	struct thread *cur = thread_current ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	cur->wait_on_rwlock = rw;
+	if (waiters != NULL)
+		list_insert_ordered (waiters, &cur->elem, prior_priority, NULL);
+	if (!thread_mlfqs)
+		rwlock_donate (rw, cur->priority, lock_donate_depth);
+	thread_block ();
+	cur->wait_on_rwlock = NULL;
+}
+
+/* RW를 기다리는 스레드 중 지금 얻을 수 있는 스레드들을 깨우는 함수.
+   writer를 우선하므로 writer가 기다리면 reader는 깨우지 않는다.
+   깨어난 스레드는 조건을 다시 확인한다. */
+static void
+rwlock_wake (struct rwlock *rw) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (rw->writer != NULL)
+		return;
+	if (rw->upgrader != NULL) {
+		/* upgrader만 남았으면 writer가 될 수 있다. */
+		if (rw->readers == 1)
+			thread_unblock (rw->upgrader);
+		return;
+	}
+	if (rw->readers > 0)
+		return;
+
+	if (!list_empty (&rw->write_waiters)) {
+		/* 기다리는 동안 기부로 priority가 바뀌었을 수 있으므로
+		   가장 높은 스레드를 깨운다. */
+		struct list_elem *e = list_min (&rw->write_waiters, prior_priority, NULL);
+		list_remove (e);
+		thread_unblock (list_entry (e, struct thread, elem));
+	} else
+		while (!list_empty (&rw->read_waiters))
+			thread_unblock (list_entry (list_pop_front (&rw->read_waiters),
+						struct thread, elem));
+}
+
+/* Acquires RW for reading, sleeping until no writer holds or
+   waits for it.  The current thread must not already hold RW.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_read_acquire (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	ASSERT (rwlock_find_hold (rw) == NULL);
+	while (rw->writer != NULL || rw->upgrader != NULL
+			|| !list_empty (&rw->write_waiters))
+		rwlock_wait (rw, &rw->read_waiters);
+	rw->readers++;
+	rwlock_hold (rw);
+	rwlock_settle (rw);
+	intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold for reading. */
+void
+rwlock_read_release (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+
+	old_level = intr_disable ();
+	ASSERT (rwlock_find_hold (rw) != NULL && rw->writer == NULL);
+	rw->readers--;
+	rwlock_unhold (rw);
+	rwlock_wake (rw);
+	rwlock_settle (rw);
+	thread_maybe_yield ();
+	intr_set_level (old_level);
+}
+
+/* Acquires RW for writing, sleeping until nobody holds it.  The
+   current thread must not already hold RW.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_write_acquire (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	ASSERT (rwlock_find_hold (rw) == NULL);
+	while (rw->writer != NULL || rw->readers > 0)
+		rwlock_wait (rw, &rw->write_waiters);
+	rw->writer = thread_current ();
+	rwlock_hold (rw);
+	rwlock_settle (rw);
+	intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold for writing. */
+void
+rwlock_write_release (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+
+	old_level = intr_disable ();
+	ASSERT (rw->writer == thread_current ());
+	rw->writer = NULL;
+	rwlock_unhold (rw);
+	rwlock_wake (rw);
+	rwlock_settle (rw);
+	thread_maybe_yield ();
+	intr_set_level (old_level);
+}
+
+/* Converts the current thread's read hold on RW into a write
+   hold, waiting for the other readers to leave.  Waiting
+   upgraders come before waiting writers.
+
+   Returns false, without waiting, if another reader is already
+   upgrading: letting both wait would deadlock.  The caller then
+   still holds RW for reading, and typically releases it and
+   calls rwlock_write_acquire() instead, after which whatever was
+   read under the read hold must be checked again. */
+bool
+rwlock_upgrade (struct rwlock *rw) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	ASSERT (rwlock_find_hold (rw) != NULL && rw->writer == NULL);
+	if (rw->upgrader != NULL) {
+		intr_set_level (old_level);
+		return false;
+	}
+
+	rw->upgrader = cur;
+	while (rw->readers > 1)
+		rwlock_wait (rw, NULL);
+	rw->upgrader = NULL;
+	rw->readers = 0;
+	rw->writer = cur;
+	rwlock_settle (rw);
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Converts the current thread's write hold on RW into a read
+   hold, letting waiting readers in unless a writer waits. */
+void
+rwlock_downgrade (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+
+	old_level = intr_disable ();
+	ASSERT (rw->writer == thread_current ());
+	rw->writer = NULL;
+	rw->readers = 1;
+	if (list_empty (&rw->write_waiters))
+		while (!list_empty (&rw->read_waiters))
+			thread_unblock (list_entry (list_pop_front (&rw->read_waiters),
+						struct thread, elem));
+	rwlock_settle (rw);
+	thread_maybe_yield ();
+	intr_set_level (old_level);
+}
+
+/* Returns true if the current thread holds RW for reading or
+   writing, false otherwise. */
+bool
+rwlock_held_by_current_thread (const struct rwlock *rw) {
+	enum intr_level old_level;
+	bool held;
+
+	ASSERT (rw != NULL);
+
+	old_level = intr_disable ();
+	held = rwlock_find_hold (rw) != NULL;
+	intr_set_level (old_level);
+	return held;
+}
+
+/* One semaphore in a condition's waiters heap. */
 struct semaphore_elem {
-   int priority;  // condition 안의 waiters에도 우선순위를 위해 저장하는 변수
-	struct list_elem elem;              /* List element. */
+	struct pheap_elem elem;             /* Heap element. */
+	struct thread *thread;              /* Waiting thread. */
+	uint64_t seq;                       /* Keeps FIFO among equal priorities. */
 	struct semaphore semaphore;         /* This semaphore. */
 };
 
+/* condition waiters heap의 비교 함수
+	기다리는 스레드의 지금 priority로 비교하고, 같으면 먼저 온 쪽이 더 크다 */
+static bool
+cond_waiter_less (const struct pheap_elem *a_, const struct pheap_elem *b_,
+		void *aux UNUSED) {
+	const struct semaphore_elem *a = pheap_entry (a_, struct semaphore_elem, elem);
+	const struct semaphore_elem *b = pheap_entry (b_, struct semaphore_elem, elem);
+
+	if (a->thread->priority != b->thread->priority)
+		return a->thread->priority < b->thread->priority;
+	return a->seq > b->seq;
+}
+
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
    code to receive the signal and act upon it. */
@@ -263,19 +994,7 @@ void
 cond_init (struct condition *cond) {
 	ASSERT (cond != NULL);
 
-	list_init (&cond->waiters);
-}
-
-/* list_insert_ordered 함수에서 사용하기 위한 함수
-	semaphore_elem 구조체의 priority를 높은 순으로 삽입하기 위한 함수 */
-static bool
-prior_waiter (const struct list_elem *a_, const struct list_elem *b_,
-            void *aux UNUSED) 
-{
-  const struct semaphore_elem *a = list_entry (a_, struct semaphore_elem, elem);
-  const struct semaphore_elem *b = list_entry (b_, struct semaphore_elem, elem);
-  
-  return a->priority > b->priority;
+	pheap_init (&cond->waiters, cond_waiter_less, NULL);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -301,6 +1020,7 @@ prior_waiter (const struct list_elem *a_, const struct list_elem *b_,
 void
 cond_wait (struct condition *cond, struct lock *lock) {
 	struct semaphore_elem waiter;
+	enum intr_level old_level;
 
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
@@ -308,8 +1028,17 @@ cond_wait (struct condition *cond, struct lock *lock) {
 	ASSERT (lock_held_by_current_thread (lock));
 
 	sema_init (&waiter.semaphore, 0);
-   waiter.priority = thread_current ()->priority;  // waiter에도 우선순위를 추가하여 insert_ordered를 가능하게
-   list_insert_ordered (&cond->waiters, &waiter.elem, prior_waiter, NULL);
+	waiter.thread = thread_current ();
+
+	/* 기다리는 동안 기부로 priority가 바뀌면 synch_requeue가 interrupt를 끄고
+		heap을 고치므로, heap은 항상 interrupt를 끄고 다룬다. */
+	old_level = intr_disable ();
+	waiter.seq = wait_seq_next++;
+	pheap_push (&cond->waiters, &waiter.elem);
+	waiter.thread->wait_cond = cond;
+	waiter.thread->cond_waiter = &waiter.elem;
+	intr_set_level (old_level);
+
 	lock_release (lock);
 	sema_down (&waiter.semaphore);
 	lock_acquire (lock);
@@ -324,14 +1053,24 @@ cond_wait (struct condition *cond, struct lock *lock) {
    interrupt handler. */
 void
 cond_signal (struct condition *cond, struct lock *lock UNUSED) {
+	struct semaphore_elem *waiter = NULL;
+	enum intr_level old_level;
+
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	if (!list_empty (&cond->waiters))
-		sema_up (&list_entry (list_pop_front (&cond->waiters),
-					struct semaphore_elem, elem)->semaphore);
+	old_level = intr_disable ();
+	if (!pheap_empty (&cond->waiters)) {
+		waiter = pheap_entry (pheap_pop (&cond->waiters),
+				struct semaphore_elem, elem);
+		waiter->thread->wait_cond = NULL;
+	}
+	intr_set_level (old_level);
+
+	if (waiter != NULL)
+		sema_up (&waiter->semaphore);
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -345,6 +1084,25 @@ cond_broadcast (struct condition *cond, struct lock *lock) {
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 
-	while (!list_empty (&cond->waiters))
+	while (!pheap_empty (&cond->waiters))
 		cond_signal (cond, lock);
 }
+
+/* Restores T's place in the semaphore and condition wait queues
+   it is in, after T's priority has changed while it was
+   blocked. */
+void
+synch_requeue (struct thread *t) {
+	struct semaphore *sema = t->wait_sema;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (sema != NULL) {
+		spin_lock (&sema->lock);
+		if (t->wait_sema == sema)
+			pheap_update (&sema->waiters, &t->wait_elem);
+		spin_unlock (&sema->lock);
+	}
+	if (t->wait_cond != NULL)
+		pheap_update (&t->wait_cond->waiters, t->cond_waiter);
+}
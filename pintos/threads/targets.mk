@@ -1,9 +1,14 @@
 threads_SRC  = threads/init.c		# Main program.
 threads_SRC += threads/thread.c		# Thread management core.
+threads_SRC += threads/cpu.c		# Per-CPU data.
 threads_SRC += threads/interrupt.c	# Interrupt core.
 threads_SRC += threads/intr-stubs.S	# Interrupt stubs.
 threads_SRC += threads/synch.c		# Synchronization.
 threads_SRC += threads/palloc.c		# Page allocator.
 threads_SRC += threads/malloc.c		# Subpage allocator.
+threads_SRC += threads/trace.c		# Tracepoints.
+threads_SRC += threads/workqueue.c	# Deferred work.
+threads_SRC += threads/softirq.c	# Deferred interrupt work.
 threads_SRC += threads/start.S		# Startup code.
+threads_SRC += threads/mpboot.S		# Application processor startup.
 threads_SRC += threads/mmu.c		    # Memory management unit related things.
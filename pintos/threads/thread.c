@@ -4,13 +4,18 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
+#include "threads/fixed-point.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
+#include "threads/softirq.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 #include "threads/malloc.h"
+#include "devices/timer.h"
 #include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -25,16 +30,6 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-
-/* 특정 트리거 까지 멈추는 스레드를 담기 위한 list */
-static struct list sleep_list;
-
-/* Idle thread. */
-static struct thread *idle_thread;
-
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
@@ -44,27 +39,86 @@ static struct lock tid_lock;
 /* Thread destruction requests */
 static struct list destruction_req;
 
-/* Statistics. */
-static long long idle_ticks;    /* # of timer ticks spent idle. */
-static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
-static long long user_ticks;    /* # of timer ticks in user programs. */
-
-/* Scheduling. */
+/* 종료된 스레드의 page를 해제하지 않고 모아두는 cache.
+   thread_create가 palloc의 bitmap 탐색과 pool lock, 4 kB 전체를
+   0으로 채우는 비용 없이 O(1)로 page를 얻을 수 있다.
+   init_thread가 struct thread 부분만 다시 0으로 채운다.
+   interrupt를 끈 상태에서만 접근한다. */
+static struct list thread_cache;
+static size_t thread_cache_cnt;
+
+/* Maximum number of pages in thread_cache.
+   Controlled by kernel command-line option "-tc=N". */
+size_t thread_cache_max = 16;
+
+/* Scheduling.
+   The run queues, the idle threads, the time slice counters and
+   the statistics are per-CPU; see cpu.h. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
-static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* MLFQS에서 사용하는 값들.
+   recent_cpu나 nice가 0이 아닌 스레드만 mlfqs_list에 넣어두어서,
+   1초마다의 recent_cpu 감쇠도 값이 실제로 바뀌는 스레드만 순회한다. */
+static fixed_t load_avg;        /* System load average. */
+static struct list mlfqs_list;  /* Threads with nonzero recent_cpu or nice. */
+
+/* If true, use the completely fair scheduler instead.
+   Controlled by kernel command-line option "-cfs". */
+bool thread_cfs;
+
+/* CFS 파라미터 (ns).
+   run queue의 모든 스레드가 CFS_LATENCY 동안 한 번씩은 돌도록 그 시간을
+   weight 비율로 나눠 time slice로 주되, 스레드가 많아지면 한 스레드가
+   CFS_MIN_GRANULARITY 이상은 돌 수 있도록 주기를 늘린다.
+   선점 검사는 timer tick마다 하므로 최소 단위도 한 tick으로 둔다. */
+#define NSEC_PER_TICK (1000000000ULL / TIMER_FREQ)
+#define CFS_LATENCY (TIME_SLICE * NSEC_PER_TICK)
+#define CFS_MIN_GRANULARITY NSEC_PER_TICK
+#define CFS_WAKEUP_GRANULARITY 1000000  /* 깨어난 스레드가 선점하는 최소 차이. */
+
+/* SCHED_FIFO budget.
+   RT 스레드들은 합쳐서 RT_PERIOD tick 중 RT_RUNTIME tick까지만
+   다른 class보다 먼저 실행된다.  다 쓰면 다음 주기까지 throttle 되어
+   다른 class의 스레드가 없을 때만 실행된다. */
+#define RT_PERIOD TIMER_FREQ
+#define RT_RUNTIME (RT_PERIOD * 95 / 100)
+
+/* nice 0의 weight.  vruntime은 실제 실행 시간에
+   CFS_NICE_0_WEIGHT / weight를 곱해서 증가한다. */
+#define CFS_NICE_0_WEIGHT 1024
+
+/* nice 값별 weight.  nice가 1 낮아질 때마다 약 1.25배씩 커져서
+   CPU를 나눠 쓰는 비율이 nice 차이 1당 약 10%씩 달라진다.
+   -20 ~ 19는 Linux의 prio_to_weight 값과 같다. */
+static const uint32_t cfs_weights[NICE_MAX - NICE_MIN + 1] = {
+	/* -20 */ 88761, 71755, 56483, 46273, 36291,
+	/* -15 */ 29154, 23254, 18705, 14949, 11916,
+	/* -10 */  9548,  7620,  6100,  4904,  3906,
+	/*  -5 */  3121,  2501,  1991,  1586,  1277,
+	/*   0 */  1024,   820,   655,   526,   423,
+	/*   5 */   335,   272,   215,   172,   137,
+	/*  10 */   110,    87,    70,    56,    45,
+	/*  15 */    36,    29,    23,    18,    15,
+	/*  20 */    12,
+};
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
+static void idle_loop (void) NO_RETURN;
+static void thread_wakeup (void *t_);
 static struct thread *next_thread_to_run (void);
 static void init_thread (struct thread *, const char *name, int priority);
+static struct thread *thread_page_get (void);
+static void thread_page_put (struct thread *);
 static void do_schedule(int status);
 static void schedule (void);
+static void schedule_tail (void);
 static tid_t allocate_tid (void);
 
 /* Returns true if T appears to point to a valid thread. */
@@ -83,28 +137,450 @@ static tid_t allocate_tid (void);
 // setup temporal gdt first.
 static uint64_t gdt[3] = { 0, 0x00af9a000000ffff, 0x00cf92000000ffff };
 
-/* list_insert_ordered 함수에서 사용하기 위한 함수
-	priority를 높은 순으로 삽입하기 위한 함수 */
+/* runqueue의 bitmap이 64bit 하나에 모든 priority를 담을 수 있어야 한다. */
+#if PRI_MAX >= 64
+#error runqueue bitmap requires PRI_MAX < 64
+#endif
+
+/* T의 nice에 해당하는 CFS weight를 반환하는 함수 */
+static inline uint64_t
+cfs_weight (const struct thread *t) {
+	return cfs_weights[t->nice - NICE_MIN];
+}
+
+/* NS 나노초를 TSC cycle로 바꾸는 함수
+	TSC를 보정하기 전에는 0을 반환한다 */
+static inline uint64_t
+cfs_ns_to_tsc (uint64_t ns) {
+	return ns * timer_tsc_hz () / 1000000000ULL;
+}
+
+/* cfs_tree의 비교 함수
+	vruntime이 같으면 나중에 넣은 스레드가 뒤에 간다 */
 static bool
-prior_priority (const struct list_elem *a_, const struct list_elem *b_,
-            void *aux UNUSED) 
-{
-  const struct thread *a = list_entry (a_, struct thread, elem);
-  const struct thread *b = list_entry (b_, struct thread, elem);
-  
-  return a->priority > b->priority;
+cfs_less (const struct rb_node *a_, const struct rb_node *b_,
+		void *aux UNUSED) {
+	const struct thread *a = rb_entry (a_, struct thread, cfs_node);
+	const struct thread *b = rb_entry (b_, struct thread, cfs_node);
+
+	return a->vruntime < b->vruntime;
 }
 
-/* list_insert_ordered 함수에서 사용하기 위한 함수
-	awake_ticks를 낮은 순으로 삽입하기 위한 함수 */
+/* rt_queue의 비교 함수
+	rt_priority가 높은 스레드가 앞에 온다 */
 static bool
-prior_tick (const struct list_elem *a_, const struct list_elem *b_,
-            void *aux UNUSED) 
-{
-  const struct thread *a = list_entry (a_, struct thread, elem);
-  const struct thread *b = list_entry (b_, struct thread, elem);
-  
-  return a->awake_ticks < b->awake_ticks;
+rt_more (const struct list_elem *a_, const struct list_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = list_entry (a_, struct thread, elem);
+	const struct thread *b = list_entry (b_, struct thread, elem);
+
+	return a->rt_priority > b->rt_priority;
+}
+
+/* T를 C의 run queue에서 자신의 priority에 해당하는 큐의 뒤에 넣는 함수
+	CFS에서는 vruntime 순서로 tree에 넣고,
+	SCHED_FIFO 스레드는 같은 rt_priority 스레드들의 뒤에 넣는다 */
+static void
+ready_queue_push (struct cpu *c, struct thread *t) {
+	struct runqueue *rq = &c->rq;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spin_lock (&rq->lock);
+	if (t->policy == SCHED_FIFO) {
+		list_insert_ordered (&rq->rt_queue, &t->elem, rt_more, NULL);
+		rq->rt_cnt++;
+	} else if (thread_cfs) {
+		rb_insert (&rq->cfs_tree, &t->cfs_node);
+		rq->load += cfs_weight (t);
+	} else {
+		list_push_back (&rq->queues[t->priority], &t->elem);
+		rq->bitmap |= 1ULL << t->priority;
+	}
+	rq->cnt++;
+	t->cpu = c;
+	spin_unlock (&rq->lock);
+}
+
+/* ready 상태인 T를 T가 들어있는 run queue에서 빼는 함수 */
+static void
+ready_queue_remove (struct thread *t) {
+	struct runqueue *rq = &t->cpu->rq;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (t->status == THREAD_READY);
+
+	spin_lock (&rq->lock);
+	if (t->policy == SCHED_FIFO) {
+		list_remove (&t->elem);
+		rq->rt_cnt--;
+	} else if (thread_cfs) {
+		rb_remove (&rq->cfs_tree, &t->cfs_node);
+		rq->load -= cfs_weight (t);
+	} else {
+		list_remove (&t->elem);
+		if (list_empty (&rq->queues[t->priority]))
+			rq->bitmap &= ~(1ULL << t->priority);
+	}
+	rq->cnt--;
+	spin_unlock (&rq->lock);
+}
+
+/* C의 run queue에 있는 스레드 중 가장 높은 priority를 반환하는 함수
+	run queue가 비어있으면 -1을 반환 */
+static int
+ready_queue_highest (struct cpu *c) {
+	uint64_t bitmap = c->rq.bitmap;
+
+	if (bitmap == 0)
+		return -1;
+	return 63 - __builtin_clzll (bitmap);
+}
+
+/* C의 run queue에서 RT 스레드가 다른 class보다 먼저 실행되어야 하는지
+	확인하는 함수. throttle 되었으면 다른 class가 비어있을 때만 실행한다.
+	run queue의 lock을 잡은 상태에서 불러야 한다 */
+static bool
+rt_runnable (struct runqueue *rq) {
+	return rq->rt_cnt > 0 && (!rq->rt_throttled || rq->cnt == rq->rt_cnt);
+}
+
+/* C의 run queue에서 가장 높은 priority 큐의 맨 앞 스레드를 꺼내서 반환하는 함수
+	CFS에서는 vruntime이 가장 작은 스레드를 꺼내고,
+	SCHED_FIFO 스레드가 있으면 그 중 rt_priority가 가장 높은 스레드를 먼저 꺼낸다
+	run queue가 비어있으면 NULL을 반환 */
+static struct thread *
+ready_queue_pop (struct cpu *c) {
+	struct runqueue *rq = &c->rq;
+	struct thread *t = NULL;
+	int priority;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spin_lock (&rq->lock);
+	if (rt_runnable (rq)) {
+		t = list_entry (list_pop_front (&rq->rt_queue), struct thread, elem);
+		rq->rt_cnt--;
+		rq->cnt--;
+		spin_unlock (&rq->lock);
+		return t;
+	}
+	if (thread_cfs) {
+		struct rb_node *first = rb_first (&rq->cfs_tree);
+
+		if (first != NULL) {
+			t = rb_entry (first, struct thread, cfs_node);
+			rb_remove (&rq->cfs_tree, first);
+			rq->load -= cfs_weight (t);
+			rq->cnt--;
+		}
+		spin_unlock (&rq->lock);
+		return t;
+	}
+	priority = ready_queue_highest (c);
+	if (priority >= 0) {
+		struct list *queue = &rq->queues[priority];
+
+		t = list_entry (list_pop_front (queue), struct thread, elem);
+		if (list_empty (queue))
+			rq->bitmap &= ~(1ULL << priority);
+		rq->cnt--;
+	}
+	spin_unlock (&rq->lock);
+
+	return t;
+}
+
+/* 자신의 run queue가 비었을 때 다른 CPU의 run queue에서
+	가장 높은 priority의 스레드를 훔쳐오는 함수
+	훔쳐올 스레드가 없으면 NULL을 반환 */
+static struct thread *
+ready_queue_steal (struct cpu *self) {
+	struct cpu *victim = NULL;
+	int best = -1;
+	struct thread *t;
+
+	for (int i = 0; i < cpu_cnt; i++) {
+		/* RT 스레드가 있는 CPU를 먼저 고르고,
+			CFS에는 priority 순서가 없으므로 가장 많이 밀려있는 CPU에서 훔친다 */
+		int highest = rt_runnable (&cpus[i].rq) ? PRI_MAX + 1
+			: thread_cfs ? (int) cpus[i].rq.cnt - 1
+			: ready_queue_highest (&cpus[i]);
+
+		if (&cpus[i] != self && highest > best) {
+			victim = &cpus[i];
+			best = highest;
+		}
+	}
+	if (victim == NULL)
+		return NULL;
+
+	t = ready_queue_pop (victim);
+	if (t != NULL) {
+		/* vruntime은 CPU마다 기준이 다르므로 min_vruntime에 대한
+			상대 위치를 유지한 채 옮긴다 */
+		if (thread_cfs)
+			t->vruntime += self->rq.min_vruntime - victim->rq.min_vruntime;
+		t->cpu = self;
+	}
+	return t;
+}
+
+/* C의 min_vruntime을 run queue와 실행 중인 스레드 CURR의
+	vruntime 중 가장 작은 값으로 올리는 함수. 내려가지는 않는다 */
+static void
+cfs_update_min_vruntime (struct cpu *c, struct thread *curr) {
+	struct runqueue *rq = &c->rq;
+	struct rb_node *first;
+	uint64_t vruntime = UINT64_MAX;
+
+	spin_lock (&rq->lock);
+	if (curr != c->idle_thread)
+		vruntime = curr->vruntime;
+	first = rb_first (&rq->cfs_tree);
+	if (first != NULL) {
+		struct thread *t = rb_entry (first, struct thread, cfs_node);
+		if (t->vruntime < vruntime)
+			vruntime = t->vruntime;
+	}
+	if (vruntime != UINT64_MAX && vruntime > rq->min_vruntime)
+		rq->min_vruntime = vruntime;
+	spin_unlock (&rq->lock);
+}
+
+/* C에서 실행 중인 스레드 T에게 마지막으로 계산한 뒤부터 지금까지
+	실행한 시간을 weight에 반비례하게 vruntime으로 더하는 함수 */
+static void
+cfs_update_curr (struct cpu *c, struct thread *t) {
+	uint64_t now = rdtsc ();
+	uint64_t delta = now - t->exec_stamp;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	t->exec_stamp = now;
+	if (t == c->idle_thread || t->policy != SCHED_OTHER)
+		return;
+	t->slice_exec += delta;
+	t->vruntime += delta * CFS_NICE_0_WEIGHT / cfs_weight (t);
+	cfs_update_min_vruntime (c, t);
+}
+
+/* C에서 실행 중인 스레드 T의 time slice를 TSC cycle로 반환하는 함수
+	target latency를 T와 run queue 전체의 weight 비율로 나눈다 */
+static uint64_t
+cfs_slice (struct cpu *c, struct thread *t) {
+	struct runqueue *rq = &c->rq;
+	uint64_t nr_running = rq->cnt + 1;
+	uint64_t period = CFS_LATENCY;
+
+	if (nr_running * CFS_MIN_GRANULARITY > period)
+		period = nr_running * CFS_MIN_GRANULARITY;
+	return cfs_ns_to_tsc (period * cfs_weight (t) / (rq->load + cfs_weight (t)));
+}
+
+/* C의 run queue에 들어가려는 T의 vruntime을 정하는 함수
+	오래 잠들어 있던 스레드가 쌓인 차이만큼 CPU를 독점하지 않도록
+	min_vruntime보다 반 latency 이상 앞서지 못하게 한다 */
+static void
+cfs_place (struct cpu *c, struct thread *t) {
+	uint64_t credit = cfs_ns_to_tsc (CFS_LATENCY / 2);
+	uint64_t min_vruntime = c->rq.min_vruntime;
+
+	if (min_vruntime > credit && t->vruntime < min_vruntime - credit)
+		t->vruntime = min_vruntime - credit;
+}
+
+/* RT 스레드 T가 C에서 선점되어야 하는지 확인하는 함수
+	budget이 남아 있으면 rt_priority가 더 높은 RT 스레드만 T를 선점하고,
+	throttle 되었으면 다른 class의 스레드가 하나라도 있으면 양보한다 */
+static bool
+rt_preempts (struct cpu *c, struct thread *t) {
+	struct runqueue *rq = &c->rq;
+	bool preempt;
+
+	spin_lock (&rq->lock);
+	if (rq->rt_throttled)
+		preempt = rq->cnt > rq->rt_cnt;
+	else
+		preempt = rq->rt_cnt > 0 && list_entry (list_front (&rq->rt_queue),
+				struct thread, elem)->rt_priority > t->rt_priority;
+	spin_unlock (&rq->lock);
+	return preempt;
+}
+
+/* C의 run queue에 실행 중인 스레드 T를 선점해야 하는 스레드가 있는지
+	확인하는 함수. 실행할 수 있는 RT 스레드는 다른 class를 항상 선점한다.
+	CFS에서는 T의 vruntime이 가장 작은 vruntime보다
+	CFS_WAKEUP_GRANULARITY 넘게 앞서 있으면 선점한다 */
+static bool
+ready_queue_preempts (struct cpu *c, struct thread *t) {
+	struct rb_node *first;
+	bool preempt;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (t == c->idle_thread)
+		return c->rq.cnt > 0;
+	if (t->policy == SCHED_FIFO)
+		return rt_preempts (c, t);
+	if (c->rq.rt_cnt > 0 && !c->rq.rt_throttled)
+		return true;
+	if (!thread_cfs)
+		return t->priority < ready_queue_highest (c);
+
+	cfs_update_curr (c, t);
+	spin_lock (&c->rq.lock);
+	first = rb_first (&c->rq.cfs_tree);
+	preempt = first != NULL
+		&& rb_entry (first, struct thread, cfs_node)->vruntime
+			+ cfs_ns_to_tsc (CFS_WAKEUP_GRANULARITY) < t->vruntime;
+	spin_unlock (&c->rq.lock);
+	return preempt;
+}
+
+/* T의 priority를 PRIORITY로 바꾸는 함수
+	T가 ready 큐에 있다면 새 priority의 큐로 옮긴다 */
+static void
+thread_change_priority (struct thread *t, int priority) {
+	enum intr_level old_level = intr_disable ();
+
+	if (t->priority != priority) {
+		if (t->status == THREAD_READY) {
+			ready_queue_remove (t);
+			t->priority = priority;
+			ready_queue_push (t->cpu, t);
+		} else {
+			t->priority = priority;
+			if (t->status == THREAD_BLOCKED)
+				synch_requeue (t);
+		}
+	}
+
+	intr_set_level (old_level);
+}
+
+/* donors heap의 비교 함수
+	기부하고 있는 스레드의 (기부받은 것을 포함한) priority로 비교한다 */
+static bool
+donor_less (const struct pheap_elem *a_, const struct pheap_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = pheap_entry (a_, struct thread, donor_elem);
+	const struct thread *b = pheap_entry (b_, struct thread, donor_elem);
+
+	return a->priority < b->priority;
+}
+
+/* T의 priority를 base_priority, donors 중 가장 높은 priority,
+	보유한 rwlock들의 waiter 중 가장 높은 priority 중 가장 큰 값으로
+	다시 계산하는 함수. donors가 heap이므로 보유한 lock들을
+	다시 훑을 필요 없이 top만 보면 된다.
+	priority가 바뀌었으면 true를 반환한다. */
+bool
+thread_refresh_priority (struct thread *t) {
+	enum intr_level old_level;
+	int priority;
+	bool changed;
+
+	if (thread_mlfqs)
+		return false;
+
+	old_level = intr_disable ();
+	priority = t->base_priority;
+	if (!pheap_empty (&t->donors)) {
+		struct thread *top = pheap_entry (pheap_top (&t->donors),
+				struct thread, donor_elem);
+		if (top->priority > priority)
+			priority = top->priority;
+	}
+	for (int i = 0; i < RW_HOLD_MAX; i++) {
+		struct rwlock *rw = t->rw_holds[i].lock;
+		if (rw != NULL && rw->donation > priority)
+			priority = rw->donation;
+	}
+	changed = t->priority != priority;
+	thread_change_priority (t, priority);
+	intr_set_level (old_level);
+
+	return changed;
+}
+
+/* MLFQS에서 T의 recent_cpu와 nice로 priority를 계산하는 함수
+	priority = PRI_MAX - (recent_cpu / 4) - (nice * 2) */
+static int
+mlfqs_priority (const struct thread *t) {
+	int priority = PRI_MAX - fp_to_int (fp_div_int (t->recent_cpu, 4)) - t->nice * 2;
+
+	if (priority < PRI_MIN)
+		return PRI_MIN;
+	if (priority > PRI_MAX)
+		return PRI_MAX;
+	return priority;
+}
+
+/* T의 recent_cpu, nice가 바뀐 뒤 mlfqs_list 포함 여부를 맞춰주는 함수
+	둘 다 0이면 앞으로 감쇠해도 값이 바뀌지 않으므로 list에서 뺀다 */
+static void
+mlfqs_track (struct thread *t) {
+	bool active = t->recent_cpu != 0 || t->nice != 0;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (active && !t->mlfqs_active)
+		list_push_back (&mlfqs_list, &t->mlfqs_elem);
+	else if (!active && t->mlfqs_active)
+		list_remove (&t->mlfqs_elem);
+	t->mlfqs_active = active;
+}
+
+/* 1초마다 load_avg를 갱신하고, mlfqs_list의 스레드만 recent_cpu를 감쇠시키는 함수
+	load_avg = (59/60) * load_avg + (1/60) * ready_threads
+	recent_cpu = (2 * load_avg) / (2 * load_avg + 1) * recent_cpu + nice */
+static void
+mlfqs_update_second (void) {
+	int ready_threads = 0;
+	fixed_t decay;
+	struct list_elem *e, *next;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (int i = 0; i < cpu_cnt; i++) {
+		ready_threads += cpus[i].rq.cnt;
+		if (cpus[i].curr != cpus[i].idle_thread)
+			ready_threads++;
+	}
+
+	load_avg = fp_add (fp_mul (fp_div_int (fp_from_int (59), 60), load_avg),
+			fp_div_int (fp_from_int (ready_threads), 60));
+	decay = fp_div (fp_mul_int (load_avg, 2), fp_add_int (fp_mul_int (load_avg, 2), 1));
+
+	for (e = list_begin (&mlfqs_list); e != list_end (&mlfqs_list); e = next) {
+		struct thread *t = list_entry (e, struct thread, mlfqs_elem);
+
+		next = list_next (e);
+		t->recent_cpu = fp_add_int (fp_mul (decay, t->recent_cpu), t->nice);
+		mlfqs_track (t);
+		thread_change_priority (t, mlfqs_priority (t));
+	}
+}
+
+/* 매 tick마다 timer 인터럽트에서 불리는 MLFQS 처리 함수
+	4 tick 사이에 recent_cpu가 바뀌는 스레드는 현재 스레드 뿐이므로
+	priority도 현재 스레드만 다시 계산한다 */
+static void
+mlfqs_tick (struct thread *t) {
+	int64_t ticks = timer_ticks ();
+	struct thread *idle_thread = this_cpu ()->idle_thread;
+
+	if (t != idle_thread) {
+		t->recent_cpu = fp_add_int (t->recent_cpu, 1);
+		mlfqs_track (t);
+	}
+
+	/* 1초마다의 갱신은 tick을 세는 CPU 0에서만 한다 */
+	if (ticks % TIMER_FREQ == 0 && this_cpu ()->id == 0)
+		mlfqs_update_second ();
+	else if (ticks % 4 == 0 && t != idle_thread)
+		thread_change_priority (t, mlfqs_priority (t));
 }
 
 /* Initializes the threading system by transforming the code
@@ -135,15 +611,19 @@ thread_init (void) {
 	lgdt (&gdt_ds);
 
 	/* Init the globla thread context */
+	cpu_init ();
+	rb_init (&this_cpu ()->rq.cfs_tree, cfs_less, NULL);
 	lock_init (&tid_lock);
-	list_init (&ready_list);
-	list_init (&sleep_list);
+	list_init (&mlfqs_list);
 	list_init (&destruction_req);
+	list_init (&thread_cache);
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread ();
 	init_thread (initial_thread, "main", PRI_DEFAULT);
 	initial_thread->status = THREAD_RUNNING;
+	initial_thread->cpu = this_cpu ();
+	this_cpu ()->curr = initial_thread;
 	initial_thread->tid = allocate_tid ();
 }
 
@@ -159,34 +639,152 @@ thread_start (void) {
 	/* Start preemptive thread scheduling. */
 	intr_enable ();
 
-	/* Wait for the idle thread to initialize idle_thread. */
+	/* Wait for the idle thread to initialize this CPU's idle_thread. */
 	sema_down (&idle_started);
 }
 
+/* Sets up the idle thread of application processor C, which
+   cpu_start_aps() is about to start, and the parts of C's run
+   queue that only this file knows about.  The processor runs
+   ap_main() on the idle thread's stack and then becomes that
+   thread through thread_start_ap().  Returns the top of the
+   stack, or a null pointer if no memory is left. */
+void *
+thread_prepare_ap (struct cpu *c) {
+	struct thread *t = thread_page_get ();
+
+	if (t == NULL)
+		return NULL;
+	init_thread (t, "idle", PRI_MIN);
+	t->tid = allocate_tid ();
+	t->status = THREAD_RUNNING;
+	t->cpu = c;
+	c->idle_thread = c->curr = t;
+	rb_init (&c->rq.cfs_tree, cfs_less, NULL);
+
+	return (uint8_t *) t + PGSIZE;
+}
+
+/* Starts scheduling on an application processor.  Called by
+   ap_main() in the idle thread set up by thread_prepare_ap(),
+   with interrupts off and the big kernel lock held. */
+void
+thread_start_ap (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (thread_current () == this_cpu ()->idle_thread);
+
+	thread_current ()->acct_stamp = rdtsc ();
+	idle_loop ();
+}
+
+/* 매 tick SCHED_FIFO budget을 관리하는 함수
+	주기가 바뀌면 budget을 다시 채우고, 실행 중인 RT 스레드 T가
+	budget을 다 쓰면 이번 주기가 끝날 때까지 RT class를 throttle 한다 */
+static void
+rt_tick (struct cpu *c, struct thread *t) {
+	struct runqueue *rq = &c->rq;
+	int64_t now = timer_ticks ();
+
+	spin_lock (&rq->lock);
+	if (now - rq->rt_period_start >= RT_PERIOD) {
+		rq->rt_period_start = now;
+		rq->rt_ticks = 0;
+		rq->rt_throttled = false;
+	}
+	if (t->policy == SCHED_FIFO && !rq->rt_throttled
+			&& ++rq->rt_ticks >= RT_RUNTIME)
+		rq->rt_throttled = true;
+	spin_unlock (&rq->lock);
+}
+
 /* Called by the timer interrupt handler at each timer tick.
    Thus, this function runs in an external interrupt context. */
 void
 thread_tick (void) {
 	struct thread *t = thread_current ();
+	struct cpu *c = this_cpu ();
 
 	/* Update statistics. */
-	if (t == idle_thread)
-		idle_ticks++;
+	if (t == c->idle_thread)
+		c->idle_ticks++;
 #ifdef USERPROG
 	else if (t->pml4 != NULL)
-		user_ticks++;
+		c->user_ticks++;
 #endif
 	else
-		kernel_ticks++;
-
-	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+		c->kernel_ticks++;
+
+	if (thread_mlfqs)
+		mlfqs_tick (t);
+	rt_tick (c, t);
+
+	/* Enforce preemption.
+	   SCHED_FIFO 스레드에는 time slice가 없다.
+	   CFS에서는 고정된 TIME_SLICE 대신 run queue의 weight로 정한
+	   time slice만큼 실행했는지를 본다. */
+	if (t->policy == SCHED_FIFO) {
+		if (ready_queue_preempts (c, t))
+			intr_yield_on_return ();
+	} else if (thread_cfs) {
+		if (ready_queue_preempts (c, t)
+				|| (t != c->idle_thread && t->slice_exec >= cfs_slice (c, t)))
+			intr_yield_on_return ();
+	} else if (++c->thread_ticks >= TIME_SLICE || ready_queue_preempts (c, t))
 		intr_yield_on_return ();
 }
 
+/* Charges the time since the last accounting point to the user
+   time of the running thread.  Called on every entry into the
+   kernel from user mode. */
+void
+thread_charge_user (void) {
+	enum intr_level old_level = intr_disable ();
+	struct thread *t = thread_current ();
+	uint64_t now = rdtsc ();
+
+	t->utime += now - t->acct_stamp;
+	t->acct_stamp = now;
+	intr_set_level (old_level);
+}
+
+/* Charges the time since the last accounting point to the kernel
+   time of the running thread.  Called right before returning to
+   user mode. */
+void
+thread_charge_system (void) {
+	enum intr_level old_level = intr_disable ();
+	struct thread *t = thread_current ();
+	uint64_t now = rdtsc ();
+
+	t->stime += now - t->acct_stamp;
+	t->acct_stamp = now;
+	intr_set_level (old_level);
+}
+
+/* Adds the CPU usage of T, which must not be running on another
+   CPU, to RU. */
+void
+thread_rusage_add (struct thread *t, struct rusage *ru) {
+	if (t == thread_current ())
+		thread_charge_system ();
+
+	ru->ru_utime += timer_tsc_to_ns (t->utime);
+	ru->ru_stime += timer_tsc_to_ns (t->stime);
+	ru->ru_wtime += timer_tsc_to_ns (t->wtime);
+	ru->ru_nvcsw += t->nvcsw;
+	ru->ru_nivcsw += t->nivcsw;
+}
+
 /* Prints thread statistics. */
 void
 thread_print_stats (void) {
+	long long idle_ticks = 0, kernel_ticks = 0, user_ticks = 0;
+
+	for (int i = 0; i < cpu_cnt; i++) {
+		idle_ticks += cpus[i].idle_ticks;
+		kernel_ticks += cpus[i].kernel_ticks;
+		user_ticks += cpus[i].user_ticks;
+	}
 	printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 			idle_ticks, kernel_ticks, user_ticks);
 }
@@ -215,7 +813,7 @@ thread_create (const char *name, int priority,
 	ASSERT (function != NULL);
 
 	/* Allocate thread. */
-	t = palloc_get_page (PAL_ZERO);
+	t = thread_page_get ();
 	if (t == NULL)
 		return TID_ERROR;
 
@@ -223,6 +821,28 @@ thread_create (const char *name, int priority,
 	init_thread (t, name, priority);
 	tid = t->tid = allocate_tid ();
 
+	/* MLFQS에서는 생성한 스레드의 nice와 recent_cpu를 물려받고,
+	   priority는 인자와 상관없이 계산한 값을 사용 */
+	if (thread_mlfqs) {
+		enum intr_level old_level = intr_disable ();
+		t->nice = thread_current ()->nice;
+		t->recent_cpu = thread_current ()->recent_cpu;
+		t->priority = mlfqs_priority (t);
+		mlfqs_track (t);
+		intr_set_level (old_level);
+	}
+
+	/* CFS에서도 nice를 물려받고, 먼저 돌던 스레드들보다 앞서지 않도록
+	   min_vruntime에 자신의 slice 만큼을 더한 위치에서 시작한다 */
+	if (thread_cfs) {
+		enum intr_level old_level = intr_disable ();
+		struct cpu *c = this_cpu ();
+		t->nice = thread_current ()->nice;
+		t->vruntime = c->rq.min_vruntime
+			+ cfs_slice (c, t) * CFS_NICE_0_WEIGHT / cfs_weight (t);
+		intr_set_level (old_level);
+	}
+
 	/* Call the kernel_thread if it scheduled.
 	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
 	t->tf.rip = (uintptr_t) kernel_thread;
@@ -234,6 +854,7 @@ thread_create (const char *name, int priority,
 	t->tf.cs = SEL_KCSEG;
 	t->tf.eflags = FLAG_IF;
 
+#ifdef USERPROG
 	struct child_state *t_state = malloc (sizeof (struct child_state));
 	if (t_state == NULL) PANIC("thread t_state malloc failed");
 
@@ -241,10 +862,10 @@ thread_create (const char *name, int priority,
 	t_state->is_dying = false;
 	t_state->cheild_ptr = t;
 
-	struct thread *cur = thread_current ();
 	list_push_back (&thread_current ()->process_child_list, &t_state->elem);
 	t->process_parent = thread_current ();
-	
+#endif
+
 	/* Add to run queue. */
 	thread_unblock (t);
 	thread_maybe_yield();	// 나보다 우선순위가 큰 스레드가 생성될 수 있으니까 체크
@@ -262,6 +883,24 @@ void
 thread_block (void) {
 	ASSERT (!intr_context ());
 	ASSERT (intr_get_level () == INTR_OFF);
+	TRACE (TRACE_BLOCK, 0);
+	thread_current ()->status = THREAD_BLOCKED;
+	schedule ();
+}
+
+/* Like thread_block(), but also releases spinlock SL, which must
+   be held.  SL is released only after the current thread's
+   context has been saved and the next thread runs.  A thread
+   that puts itself on a wait queue protected by SL can therefore
+   not be unblocked by another CPU, which has to take SL first,
+   while it is still running. */
+void
+thread_block_locked (struct spinlock *sl) {
+	ASSERT (!intr_context ());
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (sl->locked);
+	TRACE (TRACE_BLOCK, 0);
+	this_cpu ()->switch_unlock = sl;
 	thread_current ()->status = THREAD_BLOCKED;
 	schedule ();
 }
@@ -282,14 +921,19 @@ thread_unblock (struct thread *t) {
 
 	old_level = intr_disable ();
 	ASSERT (t->status == THREAD_BLOCKED);
-	list_insert_ordered (&ready_list, &t->elem, prior_priority, NULL);	// 삽입도 priority 순위에 맞게 삽입
+	TRACE (TRACE_UNBLOCK, t->tid);
+	if (thread_cfs)
+		cfs_place (this_cpu (), t);
+	ready_queue_push (this_cpu (), t);
 	t->status = THREAD_READY;
+	t->ready_stamp = rdtsc ();
+	cpu_kick_idle ();	// 쉬고 있는 CPU가 있으면 가져가도록
 	intr_set_level (old_level);
 }
 
-/* 현재 스레드를 sleep 하는 함수
-	이 함수를 사용하는 순간의 스레드를 sleep_list에 넣는다
-	(이미 running 상태여서 ready_list에서 pop 되었기 떄문에 따로 list_remove는 필요없음) */
+/* 현재 스레드를 alarm_ticks 까지 sleep 하는 함수
+	스레드에 내장된 sleep_timer를 timer wheel에 등록하고 block 하며,
+	timer가 만료되면 timer 인터럽트에서 thread_wakeup이 불려 unblock 된다 */
 void
 thread_sleep (int64_t alarm_ticks)
 {
@@ -300,39 +944,18 @@ thread_sleep (int64_t alarm_ticks)
 
 	current_thread = thread_current ();
 	ASSERT(current_thread->status == THREAD_RUNNING);
-	current_thread->awake_ticks = alarm_ticks;
-	list_insert_ordered (&sleep_list, &current_thread->elem, prior_tick, NULL);
+	timer_arm (&current_thread->sleep_timer, alarm_ticks, thread_wakeup, current_thread);
 	thread_block ();
 
 	intr_set_level (old_level);
 }
 
-/* 자고있는 스레드들을 깨우는 함수
-	매개변수로 현재 tick을 받으며, sleep_list의 가장 앞의 스레드의
-	awake_ticks과 비교하여 현재 tick이 넘어갈 경우 해당 스레드를 unblock 한다 */
-void
-thread_wakeup (int64_t current_ticks)
+/* sleep_timer가 만료되었을 때 timer 인터럽트에서 불리는 함수
+	sleep 하던 스레드를 unblock 한다 */
+static void
+thread_wakeup (void *t_)
 {
-	struct thread *current_thread;
-	enum intr_level old_level;
-
-	if (!list_empty (&sleep_list)) {
-		old_level = intr_disable ();
-
-		for (struct list_elem *elem = list_begin(&sleep_list); elem != list_end(&sleep_list); elem = list_begin(&sleep_list)) {
-			current_thread = list_entry(elem, struct thread, elem);
-
-			if (current_thread->awake_ticks <= current_ticks) {
-				list_remove(elem);
-				thread_unblock(current_thread);
-			}
-			else {
-				break;
-			}
-		}
-
-		intr_set_level (old_level);
-	}
+	thread_unblock (t_);
 }
 
 /* Returns the name of the running thread. */
@@ -378,13 +1001,15 @@ thread_exit (void) {
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable ();
+	if (thread_current ()->mlfqs_active)
+		list_remove (&thread_current ()->mlfqs_elem);
 	do_schedule (THREAD_DYING);
 	NOT_REACHED ();
 }
 
 /* Yields the CPU.  The current thread is not put to sleep and
    may be scheduled again immediately at the scheduler's whim. 
-   현재 스레드를 read 상태로 만든 뒤 ready_list에 넣고 스케쥴링 동작하는 함수 */
+   현재 스레드를 read 상태로 만든 뒤 ready 큐에 넣고 스케쥴링 동작하는 함수 */
 void
 thread_yield (void) {
 	struct thread *curr = thread_current ();
@@ -393,19 +1018,21 @@ thread_yield (void) {
 	ASSERT (!intr_context ());
 
 	old_level = intr_disable ();
-	if (curr != idle_thread)
-		list_insert_ordered (&ready_list, &curr->elem, prior_priority, NULL);	// 삽입도 priority 순위에 맞게 삽입
+	if (thread_cfs)
+		cfs_update_curr (this_cpu (), curr);	// tree에 넣은 뒤에는 vruntime을 바꿀 수 없다
+	if (curr != this_cpu ()->idle_thread)
+		ready_queue_push (this_cpu (), curr);
 	do_schedule (THREAD_READY);
 	intr_set_level (old_level);
 }
 
-/* 현재 스레드가 ready_list의 앞의 스레드와 비교하고 스위칭 하는 함수  */
+/* 현재 스레드가 ready 큐의 가장 높은 priority와 비교하고 스위칭 하는 함수  */
 void
 thread_maybe_yield (void) {
 	enum intr_level old_level = intr_disable ();
 
-	if (!list_empty (&ready_list) && thread_current ()->priority < list_entry (list_front (&ready_list), struct thread, elem)->priority) {
-		if (intr_context())
+	if (ready_queue_preempts (this_cpu (), thread_current ())) {
+		if (intr_context () || softirq_context ())
 			intr_yield_on_return();
         else
 			thread_yield();
@@ -414,10 +1041,15 @@ thread_maybe_yield (void) {
 	intr_set_level (old_level);
 }
 
-/* Sets the current thread's priority to NEW_PRIORITY. */
+/* Sets the current thread's priority to NEW_PRIORITY.
+   MLFQS에서는 priority를 스케줄러가 정하므로 무시한다. */
 void
 thread_set_priority (int new_priority) {
-	thread_current ()->priority = new_priority;
+	if (thread_mlfqs)
+		return;
+
+	thread_current ()->base_priority = new_priority;
+	thread_refresh_priority (thread_current ());	// 기부받는 중이면 그대로 유지
 	thread_maybe_yield();	// 세팅된 priority가 낮은 순위일 수 있으니까 체크
 }
 
@@ -429,31 +1061,93 @@ thread_get_priority (void) {
 
 /* Sets the current thread's nice value to NICE. */
 void
-thread_set_nice (int nice UNUSED) {
-	/* TODO: Your implementation goes here */
+thread_set_nice (int nice) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (NICE_MIN <= nice && nice <= NICE_MAX);
+
+	old_level = intr_disable ();
+	if (thread_cfs) {
+		cfs_update_curr (this_cpu (), cur);	// 지금까지는 이전 weight로 계산
+		cur->nice = nice;
+	} else if (thread_mlfqs) {
+		cur->nice = nice;
+		mlfqs_track (cur);
+		cur->priority = mlfqs_priority (cur);
+	} else
+		cur->nice = nice;	// priority 스케줄러에서는 base priority와 기부를 건드리지 않는다
+	intr_set_level (old_level);
+
+	thread_maybe_yield ();	// 낮아진 priority 때문에 양보해야 할 수 있으니까 체크
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable ();
+	int load_avg_100 = fp_round (fp_mul_int (load_avg, 100));
+	intr_set_level (old_level);
+
+	return load_avg_100;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) {
-	/* TODO: Your implementation goes here */
+	enum intr_level old_level = intr_disable ();
+	int recent_cpu_100 = fp_round (fp_mul_int (thread_current ()->recent_cpu, 100));
+	intr_set_level (old_level);
+
+	return recent_cpu_100;
+}
+
+/* 현재 스레드의 scheduling class를 POLICY로 바꾸는 함수
+	SCHED_FIFO이면 RT_PRIORITY가 SCHED_RT_PRIO_MIN 이상
+	SCHED_RT_PRIO_MAX 이하여야 하고, SCHED_OTHER이면 0이어야 한다.
+	성공하면 0, 인자가 잘못되었으면 -1을 반환 */
+int
+thread_set_scheduler (int policy, int rt_priority) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
+	if (policy == SCHED_FIFO) {
+		if (rt_priority < SCHED_RT_PRIO_MIN || rt_priority > SCHED_RT_PRIO_MAX)
+			return -1;
+	} else if (policy != SCHED_OTHER || rt_priority != 0)
+		return -1;
+
+	old_level = intr_disable ();
+	if (thread_cfs) {
+		struct cpu *c = this_cpu ();
+
+		/* RT로 돌던 동안의 vruntime은 멈춰 있었으므로
+			min_vruntime 뒤에서 시작하지 않도록 맞춘다 */
+		cfs_update_curr (c, cur);
+		if (policy == SCHED_OTHER && cur->policy != SCHED_OTHER
+				&& cur->vruntime < c->rq.min_vruntime)
+			cur->vruntime = c->rq.min_vruntime;
+	}
+	cur->policy = policy;
+	cur->rt_priority = rt_priority;
+	intr_set_level (old_level);
+
+	thread_maybe_yield ();	// SCHED_OTHER로 내려왔으면 RT 스레드에게 양보해야 할 수 있다
 	return 0;
 }
 
+/* Returns the current thread's scheduling class. */
+int
+thread_get_scheduler (void) {
+	return thread_current ()->policy;
+}
+
 /* Idle thread.  Executes when no other thread is ready to run.
 
    The idle thread is initially put on the ready list by
@@ -462,19 +1156,31 @@ thread_get_recent_cpu (void) {
    to it to enable thread_start() to continue, and immediately
    blocks.  After that, the idle thread never appears in the
    ready list.  It is returned by next_thread_to_run() as a
-   special case when the ready list is empty. */
+   special case when the ready list is empty.
+
+   This is the bootstrap processor's idle thread.  Application
+   processors get theirs from thread_prepare_ap(). */
 static void
 idle (void *idle_started_ UNUSED) {
 	struct semaphore *idle_started = idle_started_;
 
-	idle_thread = thread_current ();
+	this_cpu ()->idle_thread = thread_current ();
 	sema_up (idle_started);
+	idle_loop ();
+}
 
+/* Body of every CPU's idle thread.  Holds the big kernel lock
+   except while halted. */
+static void
+idle_loop (void) {
 	for (;;) {
 		/* Let someone else run. */
 		intr_disable ();
 		thread_block ();
 
+		/* 실행할 스레드가 없으니 다음 timer가 만료될 때까지 주기적인 틱을 멈춘다 */
+		timer_idle_enter ();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -486,8 +1192,15 @@ idle (void *idle_started_ UNUSED) {
 		   time.
 
 		   See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
-		   7.11.1 "HLT Instruction". */
+		   7.11.1 "HLT Instruction".
+
+		   The big kernel lock is released while halted, so that
+		   other CPUs can run kernel code, and the interrupt that
+		   wakes us up takes it on its own in intr_handler(). */
+		intr_mark_enable ();
+		bkl_release ();
 		asm volatile ("sti; hlt" : : : "memory");
+		bkl_acquire ();
 	}
 }
 
@@ -496,6 +1209,7 @@ static void
 kernel_thread (thread_func *function, void *aux) {
 	ASSERT (function != NULL);
 
+	schedule_tail ();
 	intr_enable ();       /* The scheduler runs with interrupts off. */
 	function (aux);       /* Execute the thread function. */
 	thread_exit ();       /* If function() returns, kill the thread. */
@@ -510,17 +1224,61 @@ init_thread (struct thread *t, const char *name, int priority) {
 	ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
 	ASSERT (name != NULL);
 
-	memset (t, 0, sizeof *t);
+	/* struct thread is over 1 kB, mostly the two intr_frames and
+	   rw_holds, so set each member here instead of clearing the
+	   whole struct.  List, heap and tree elements are set up on
+	   insertion, and fork_tf is filled in before it is used. */
+	t->tid = 0;
 	t->status = THREAD_BLOCKED;
+	t->sleep_timer.armed = false;
 	strlcpy (t->name, name, sizeof t->name);
-	t->tf.rsp = (uint64_t) t + PGSIZE - sizeof (void *);
 	t->priority = priority;
-	t->magic = THREAD_MAGIC;
 
-	t->exit_status = 0;
+	t->base_priority = priority;
+	t->wait_on_lock = NULL;
+	pheap_init (&t->donors, donor_less, NULL);
+	t->wait_on_rwlock = NULL;
+	for (int i = 0; i < RW_HOLD_MAX; i++)
+		t->rw_holds[i].lock = NULL;
+
+	t->nice = 0;
+	t->recent_cpu = 0;
+	t->mlfqs_active = false;
+
+	t->vruntime = 0;
+	t->exec_stamp = rdtsc ();
+	t->slice_exec = 0;
+	t->policy = SCHED_OTHER;
+	t->rt_priority = 0;
+	t->cpu = NULL;
+
+	t->acct_stamp = 0;
+	t->ready_stamp = 0;
+	t->utime = t->stime = t->wtime = 0;
+	t->nvcsw = t->nivcsw = 0;
+
+	t->wait_sema = NULL;
+	t->wait_cond = NULL;
+	t->cond_waiter = NULL;
+	t->wait_seq = 0;
+	t->wait_killable = false;
+	t->killed = false;
+
+#ifdef USERPROG
+	t->pml4 = NULL;
+	t->process = NULL;
+	t->stack_slot = -1;
+	t->process_parent = NULL;
 	list_init (&t->process_child_list);
 	sema_init (&t->exit_sema, 0);
 	sema_init (&t->fork_sema, 0);
+	t->fork_success = false;
+	t->exit_status = 0;
+#endif
+
+	memset (&t->tf, 0, sizeof t->tf);
+	t->tf.rsp = (uint64_t) t + PGSIZE - sizeof (void *);
+	t->magic = THREAD_MAGIC;
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
@@ -528,18 +1286,25 @@ init_thread (struct thread *t, const char *name, int priority) {
    empty.  (If the running thread can continue running, then it
    will be in the run queue.)  If the run queue is empty, return
    idle_thread. 
-   ready_list에서 다음 실행할 스레드를 선택해서 반환, 만약 리스트에 아무것도 없을 경우 idle_thread를 반환  */
+   현재 CPU의 run queue에서 다음 실행할 스레드를 선택해서 반환,
+   비어있으면 다른 CPU에서 훔쳐오고, 그래도 없을 경우 idle_thread를 반환  */
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list))
-		return idle_thread;
-	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+	struct cpu *c = this_cpu ();
+	struct thread *next = ready_queue_pop (c);
+
+	if (next == NULL)
+		next = ready_queue_steal (c);
+	return next != NULL ? next : c->idle_thread;
 }
 
-/* Use iretq to launch the thread */
+/* Use iretq to launch the thread.  Returning to user mode drops
+   the big kernel lock and switches back to the user's GS base. */
 void
 do_iret (struct intr_frame *tf) {
+	if (tf->cs == SEL_UCSEG)
+		bkl_exit ();
+
 	__asm __volatile(
 			"movq %0, %%rsp\n"
 			"movq 0(%%rsp),%%r15\n"
@@ -561,7 +1326,10 @@ do_iret (struct intr_frame *tf) {
 			"movw 8(%%rsp),%%ds\n"
 			"movw (%%rsp),%%es\n"
 			"addq $32, %%rsp\n"
-			"iretq"
+			"testb $3, 8(%%rsp)\n"
+			"jz 1f\n"
+			"swapgs\n"
+			"1: iretq"
 			: : "g" ((uint64_t) tf) : "memory");
 }
 
@@ -646,7 +1414,7 @@ do_schedule(int status) {
 	while (!list_empty (&destruction_req)) {
 		struct thread *victim =
 			list_entry (list_pop_front (&destruction_req), struct thread, elem);
-		palloc_free_page(victim);
+		thread_page_put (victim);
 	}
 	thread_current ()->status = status;
 	schedule ();
@@ -656,15 +1424,46 @@ static void
 schedule (void) {
 	struct thread *curr = running_thread ();
 	struct thread *next = next_thread_to_run ();
+	struct thread *idle = this_cpu ()->idle_thread;
+	uint64_t now = rdtsc ();
 
 	ASSERT (intr_get_level () == INTR_OFF);
 	ASSERT (curr->status != THREAD_RUNNING);
 	ASSERT (is_thread (next));
+	TRACE (TRACE_SCHEDULE, next->tid);
 	/* Mark us as running. */
 	next->status = THREAD_RUNNING;
 
+	/* 잠들거나 종료하는 스레드의 마지막 실행 시간도 vruntime에 반영한다.
+		ready로 돌아가는 스레드는 thread_yield에서 이미 반영했다 */
+	if (thread_cfs && curr->status != THREAD_READY)
+		cfs_update_curr (this_cpu (), curr);
+
 	/* Start new time slice. */
-	thread_ticks = 0;
+	this_cpu ()->curr = next;
+	this_cpu ()->thread_ticks = 0;
+	next->exec_stamp = now;
+	next->slice_exec = 0;
+
+	/* 인터럽트가 idle 스레드를 깨워 바로 다른 스레드로 넘어가는 경우에도
+		멈춰 있던 틱을 다시 켠다 */
+	if (next != idle)
+		timer_idle_exit ();
+
+	/* CPU 사용량 기록: 나가는 스레드의 커널 시간, 스위치 종류,
+		들어오는 스레드가 run queue에서 기다린 시간 */
+	curr->stime += now - curr->acct_stamp;
+	if (curr != next && curr != idle) {
+		if (curr->status == THREAD_BLOCKED)
+			curr->nvcsw++;
+		else if (curr->status == THREAD_READY) {
+			curr->nivcsw++;
+			curr->ready_stamp = now;
+		}
+	}
+	if (curr != next && next != idle)
+		next->wtime += now - next->ready_stamp;
+	next->acct_stamp = now;
 
 #ifdef USERPROG
 	/* Activate the new address space. */
@@ -688,6 +1487,59 @@ schedule (void) {
 		 * of current running. */
 		thread_launch (next);
 	}
+	schedule_tail ();
+}
+
+/* Finishes a switch in the thread that now runs, which is where
+   thread_launch() returns to, or kernel_thread() for a new
+   thread: releases the spinlock that thread_block_locked() left
+   held, and lets a CPU waiting for the big kernel lock in. */
+static void
+schedule_tail (void) {
+	struct cpu *c = this_cpu ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (c->switch_unlock != NULL) {
+		spin_unlock (c->switch_unlock);
+		c->switch_unlock = NULL;
+	}
+	bkl_handoff ();
+}
+
+/* 새 스레드에 사용할 page를 반환하는 함수.
+   thread_cache에 있으면 꺼내 쓰고, 없으면 palloc에서 받는다.
+   init_thread가 struct thread의 멤버를 모두 설정하므로 page를
+   0으로 채울 필요는 없다. */
+static struct thread *
+thread_page_get (void) {
+	struct thread *t = NULL;
+	enum intr_level old_level = intr_disable ();
+
+	if (!list_empty (&thread_cache)) {
+		t = list_entry (list_pop_front (&thread_cache), struct thread, elem);
+		thread_cache_cnt--;
+	}
+	intr_set_level (old_level);
+
+	if (t == NULL)
+		t = palloc_get_page (0);
+	return t;
+}
+
+/* 종료된 스레드 T의 page를 thread_cache에 넣는 함수.
+   cache가 가득 찼으면 palloc에 돌려준다. */
+static void
+thread_page_put (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (thread_cache_cnt >= thread_cache_max) {
+		palloc_free_page (t);
+		return;
+	}
+	t->magic = 0;	// 죽은 스레드를 가리키는 포인터가 is_thread를 통과하지 않도록
+	list_push_front (&thread_cache, &t->elem);
+	thread_cache_cnt++;
 }
 
 /* Returns a tid to use for a new thread. */
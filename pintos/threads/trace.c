@@ -0,0 +1,173 @@
+#include "threads/trace.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+#ifdef FILESYS
+#include "devices/disk.h"
+#endif
+
+/* Pages of trace buffer per CPU. */
+#define TRACE_PAGES 64
+#define TRACE_RECORDS (TRACE_PAGES * PGSIZE / sizeof (struct trace_record))
+
+/* A per-CPU ring buffer.  Only its own CPU writes to it, with
+   interrupts off, so no lock is needed. */
+struct trace_ring {
+	struct trace_record *records;   /* TRACE_RECORDS slots. */
+	uint64_t head;                  /* Total records ever written. */
+};
+
+/* True while TRACE() records events. */
+bool trace_enabled;
+
+static struct trace_ring rings[NCPU_MAX];
+static uint64_t start_tsc;
+static int64_t start_ticks;
+
+/* Allocates the ring buffers and starts tracing.  Must be
+   called after palloc_init() and thread_init(). */
+void
+trace_init (void) {
+	for (int i = 0; i < cpu_cnt; i++)
+		trace_init_cpu (i);
+	start_ticks = timer_ticks ();
+	start_tsc = rdtsc ();
+	trace_enabled = true;
+}
+
+/* Allocates the ring buffer of CPU number ID.  Called by
+   cpu_start_aps() for each CPU that comes up after trace_init(). */
+void
+trace_init_cpu (int id) {
+	rings[id].records = palloc_get_multiple (PAL_ZERO, TRACE_PAGES);
+	if (rings[id].records == NULL)
+		PANIC ("trace: out of memory");
+	rings[id].head = 0;
+}
+
+/* Appends EVENT with argument ARG to the current CPU's ring.
+   Use the TRACE() macro instead of calling this directly. */
+void
+trace_record (enum trace_event event, uint64_t arg) {
+	enum intr_level old_level = intr_disable ();
+	struct cpu *c = this_cpu ();
+	struct trace_ring *ring = &rings[c->id];
+	struct trace_record *r = &ring->records[ring->head++ % TRACE_RECORDS];
+
+	/* thread_current() asserts that the thread is running, which
+	   is not true in the middle of schedule(). */
+	r->tsc = rdtsc ();
+	r->event = event;
+	r->cpu = c->id;
+	r->tid = ((struct thread *) pg_round_down (rrsp ()))->tid;
+	r->arg = arg;
+	intr_set_level (old_level);
+}
+
+#ifdef FILESYS
+/* Sector-sized staging buffer for trace_dump(). */
+static uint8_t dump_buf[DISK_SECTOR_SIZE];
+static size_t dump_ofs;
+
+/* Appends SIZE bytes from BUF to the scratch disk D, writing
+   each sector once it is full. */
+static void
+dump_bytes (struct disk *d, disk_sector_t *sector, const void *buf_,
+		size_t size) {
+	const uint8_t *buf = buf_;
+
+	while (size > 0) {
+		size_t chunk = DISK_SECTOR_SIZE - dump_ofs;
+		if (chunk > size)
+			chunk = size;
+		memcpy (dump_buf + dump_ofs, buf, chunk);
+		dump_ofs += chunk;
+		buf += chunk;
+		size -= chunk;
+		if (dump_ofs == DISK_SECTOR_SIZE) {
+			if (*sector >= disk_size (d))
+				return;
+			disk_write (d, (*sector)++, dump_buf);
+			dump_ofs = 0;
+		}
+	}
+}
+#endif
+
+/* Stops tracing and writes the trace to the scratch disk.  See
+   trace.h for the format. */
+void
+trace_dump (void) {
+#ifdef FILESYS
+	struct trace_header h;
+	struct disk *d;
+	disk_sector_t sector = 0;
+	uint64_t total = 0, room, written = 0;
+
+	if (!trace_enabled)
+		return;
+	trace_enabled = false;
+
+	/* Disk I/O sleeps. */
+	if (intr_context () || intr_get_level () == INTR_OFF) {
+		printf ("trace: cannot dump with interrupts off\n");
+		return;
+	}
+	d = disk_get (1, 0);
+	if (d == NULL) {
+		printf ("trace: no scratch disk (hdc or hd1:0)\n");
+		return;
+	}
+
+	for (int i = 0; i < cpu_cnt; i++)
+		total += rings[i].head < TRACE_RECORDS ? rings[i].head : TRACE_RECORDS;
+
+	/* Everything after the header sector is for records.  If they
+	   do not all fit, keep the ones that come first in the file. */
+	room = (disk_size (d) - 1) * DISK_SECTOR_SIZE / sizeof (struct trace_record);
+
+	memset (&h, 0, sizeof h);
+	memcpy (h.magic, "TRC", 4);
+	h.record_size = sizeof (struct trace_record);
+	h.record_cnt = total < room ? total : room;
+	h.timer_freq = TIMER_FREQ;
+	h.start_tsc = start_tsc;
+	h.start_ticks = start_ticks;
+	h.end_ticks = timer_ticks ();
+	h.end_tsc = rdtsc ();
+
+	dump_ofs = 0;
+	memset (dump_buf, 0, sizeof dump_buf);
+	memcpy (dump_buf, &h, sizeof h);
+	disk_write (d, sector++, dump_buf);
+
+	for (int i = 0; i < cpu_cnt; i++) {
+		struct trace_ring *ring = &rings[i];
+		uint64_t first = ring->head > TRACE_RECORDS ? ring->head - TRACE_RECORDS : 0;
+
+		for (uint64_t n = first; n < ring->head && written < h.record_cnt; n++) {
+			dump_bytes (d, &sector, &ring->records[n % TRACE_RECORDS],
+					sizeof (struct trace_record));
+			written++;
+		}
+	}
+	if (dump_ofs > 0 && sector < disk_size (d)) {
+		memset (dump_buf + dump_ofs, 0, DISK_SECTOR_SIZE - dump_ofs);
+		disk_write (d, sector++, dump_buf);
+	}
+
+	if (written < total)
+		printf ("trace: scratch disk full, trace truncated: wrote %"PRIu64
+				" of %"PRIu64" records\n", written, total);
+	else
+		printf ("trace: wrote %"PRIu64" records to scratch disk\n", written);
+#endif
+}
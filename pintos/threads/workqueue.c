@@ -0,0 +1,290 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+
+/* All of the state of a workqueue and of its work items is
+   protected by disabling interrupts, so that work can be queued
+   from interrupt handlers.  Workers sleep on the `avail'
+   semaphore, which is upped once per queued item.  An item may
+   be cancelled after its up, so a worker that wakes up to an
+   empty queue just goes back to sleep. */
+
+struct workqueue *system_wq;
+
+static void worker (void *wq_);
+static bool spawn_worker (struct workqueue *);
+static void wake_flushers (struct workqueue *);
+static void delayed_work_fire (void *work_);
+
+/* list_insert_ordered 함수에서 사용하기 위한 함수
+	priority가 높은 work가 앞에 오도록 삽입하기 위한 함수 */
+static bool
+work_prior (const struct list_elem *a_, const struct list_elem *b_,
+		void *aux UNUSED) {
+	const struct work *a = list_entry (a_, struct work, elem);
+	const struct work *b = list_entry (b_, struct work, elem);
+
+	return a->priority > b->priority;
+}
+
+/* Creates the system workqueue.  Must be called after
+   thread_start(). */
+void
+workqueue_init (void) {
+	system_wq = workqueue_create ("events", 8);
+	if (system_wq == NULL)
+		PANIC ("could not create system workqueue");
+}
+
+/* Creates and returns a workqueue named NAME whose pool grows to
+   at most MAX_WORKERS threads.  Returns a null pointer if memory
+   or a thread cannot be allocated. */
+struct workqueue *
+workqueue_create (const char *name, size_t max_workers) {
+	struct workqueue *wq;
+
+	ASSERT (name != NULL);
+	ASSERT (max_workers > 0);
+	ASSERT (!intr_context ());
+
+	wq = malloc (sizeof *wq);
+	if (wq == NULL)
+		return NULL;
+
+	strlcpy (wq->name, name, sizeof wq->name);
+	list_init (&wq->pending);
+	sema_init (&wq->avail, 0);
+	list_init (&wq->flushers);
+	wq->nr_workers = 0;
+	wq->nr_busy = 0;
+	wq->max_workers = max_workers;
+
+	if (!spawn_worker (wq)) {
+		free (wq);
+		return NULL;
+	}
+	return wq;
+}
+
+/* Initializes WORK to run FUNC at PRIORITY. */
+void
+work_init (struct work *work, work_func *func, int priority) {
+	ASSERT (work != NULL);
+	ASSERT (func != NULL);
+	ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+
+	memset (work, 0, sizeof *work);
+	work->func = func;
+	work->priority = priority;
+}
+
+/* Queues WORK on WQ.  Returns true if it was queued, false if
+   it was already pending.  May be called from an interrupt
+   handler. */
+bool
+queue_work (struct workqueue *wq, struct work *work) {
+	enum intr_level old_level;
+	bool queued = false;
+
+	ASSERT (wq != NULL);
+	ASSERT (work != NULL);
+
+	old_level = intr_disable ();
+	if (!work->pending) {
+		work->wq = wq;
+		work->pending = true;
+		list_insert_ordered (&wq->pending, &work->elem, work_prior, NULL);
+		queued = true;
+	}
+	intr_set_level (old_level);
+
+	if (queued)
+		sema_up (&wq->avail);
+	return queued;
+}
+
+/* Queues WORK on WQ after TICKS timer ticks.  Returns true if
+   the timer was armed or the work queued, false if WORK was
+   already pending or waiting for its delay.  May be called from
+   an interrupt handler. */
+bool
+queue_delayed_work (struct workqueue *wq, struct work *work, int64_t ticks) {
+	enum intr_level old_level;
+	bool armed = false;
+
+	ASSERT (wq != NULL);
+	ASSERT (work != NULL);
+
+	if (ticks <= 0)
+		return queue_work (wq, work);
+
+	old_level = intr_disable ();
+	if (!work->pending && !work->timer.armed) {
+		work->wq = wq;
+		timer_arm (&work->timer, timer_ticks () + ticks,
+				delayed_work_fire, work);
+		armed = true;
+	}
+	intr_set_level (old_level);
+
+	return armed;
+}
+
+/* Timer callback for queue_delayed_work(). */
+static void
+delayed_work_fire (void *work_) {
+	struct work *work = work_;
+
+	queue_work (work->wq, work);
+}
+
+/* Cancels WORK if it is pending or waiting for its delay.
+   Returns true if it was cancelled before it could run.  WORK
+   may still be running when this returns; see
+   cancel_work_sync().  May be called from an interrupt
+   handler. */
+bool
+cancel_work (struct work *work) {
+	enum intr_level old_level;
+	bool cancelled;
+
+	ASSERT (work != NULL);
+
+	old_level = intr_disable ();
+	cancelled = timer_cancel (&work->timer);
+	if (work->pending) {
+		list_remove (&work->elem);
+		work->pending = false;
+		cancelled = true;
+		/* A flush may be waiting for this item to leave the queue. */
+		wake_flushers (work->wq);
+	}
+	intr_set_level (old_level);
+
+	return cancelled;
+}
+
+/* Cancels WORK like cancel_work(), then waits until WORK is no
+   longer running.  Afterward WORK may be freed, unless
+   something queues it again. */
+bool
+cancel_work_sync (struct work *work) {
+	bool cancelled = cancel_work (work);
+
+	flush_work (work);
+	return cancelled;
+}
+
+/* Waits until WORK is neither pending nor running.  Does not
+   wait for a delayed WORK whose timer has not fired yet. */
+void
+flush_work (struct work *work) {
+	enum intr_level old_level;
+
+	ASSERT (work != NULL);
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	while (work->pending || work->running) {
+		list_push_back (&work->wq->flushers, &thread_current ()->elem);
+		thread_block ();
+	}
+	intr_set_level (old_level);
+}
+
+/* Waits until every item queued on WQ before the call has run,
+   that is, until WQ has no pending or running work.  Does not
+   wait for delayed work whose timer has not fired yet. */
+void
+flush_workqueue (struct workqueue *wq) {
+	enum intr_level old_level;
+
+	ASSERT (wq != NULL);
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	while (!list_empty (&wq->pending) || wq->nr_busy > 0) {
+		list_push_back (&wq->flushers, &thread_current ()->elem);
+		thread_block ();
+	}
+	intr_set_level (old_level);
+}
+
+/* Wakes every thread blocked in a flush on WQ, so that each can
+   recheck what it waits for.  Interrupts must be off. */
+static void
+wake_flushers (struct workqueue *wq) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (!list_empty (&wq->flushers))
+		thread_unblock (list_entry (list_pop_front (&wq->flushers),
+					struct thread, elem));
+}
+
+/* Adds a worker thread to WQ.  Returns true if successful. */
+static bool
+spawn_worker (struct workqueue *wq) {
+	char name[16];
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	wq->nr_workers++;
+	intr_set_level (old_level);
+
+	snprintf (name, sizeof name, "kworker/%s", wq->name);
+	if (thread_create (name, PRI_DEFAULT, worker, wq) == TID_ERROR) {
+		old_level = intr_disable ();
+		wq->nr_workers--;
+		intr_set_level (old_level);
+		return false;
+	}
+	return true;
+}
+
+/* Worker thread body.  Runs WQ's pending work forever. */
+static void
+worker (void *wq_) {
+	struct workqueue *wq = wq_;
+
+	for (;;) {
+		enum intr_level old_level;
+		struct work *work;
+		bool grow;
+
+		sema_down (&wq->avail);
+
+		old_level = intr_disable ();
+		if (list_empty (&wq->pending)) {
+			/* Cancelled after it was queued. */
+			intr_set_level (old_level);
+			continue;
+		}
+		work = list_entry (list_pop_front (&wq->pending), struct work, elem);
+		work->pending = false;
+		work->running = true;
+		wq->nr_busy++;
+
+		/* Every worker is busy but there is more work: grow the
+		   pool.  We do it here, not in queue_work(), because
+		   queue_work() may run in an interrupt handler. */
+		grow = !list_empty (&wq->pending) && wq->nr_busy == wq->nr_workers
+			&& wq->nr_workers < wq->max_workers;
+		intr_set_level (old_level);
+
+		if (grow)
+			spawn_worker (wq);
+
+		thread_set_priority (work->priority);
+		work->func (work);
+
+		old_level = intr_disable ();
+		work->running = false;
+		wq->nr_busy--;
+		wake_flushers (wq);
+		intr_set_level (old_level);
+	}
+}
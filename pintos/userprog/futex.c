@@ -0,0 +1,172 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/process.h"
+
+/* Fast user-space mutexes.
+
+   A user program keeps its lock state in an ordinary int in its
+   own memory and changes it with atomic instructions, entering
+   the kernel only when it has to sleep or to wake a sleeper.
+
+   Sleepers are kept in a fixed table of hashed wait queues
+   keyed by the physical address of the int, so that a futex
+   shared by two address spaces (e.g. through a shared mapping)
+   is the same futex in both.  Each bucket has its own spinlock.
+
+   futex_wait() checks the value and goes to sleep atomically
+   with respect to futex_wake(): both hold the bucket lock, so a
+   wake that follows a change of the value cannot be lost. */
+
+#define FUTEX_BUCKETS 64
+
+/* A hashed wait queue. */
+struct futex_bucket {
+	struct spinlock lock;       /* Protects WAITERS. */
+	struct list waiters;        /* struct futex_waiter, by priority. */
+};
+
+/* A thread sleeping in futex_wait().  Lives on its stack. */
+struct futex_waiter {
+	uintptr_t key;              /* Physical address waited on. */
+	struct thread *thread;      /* Sleeping thread. */
+	struct list_elem elem;      /* Element in bucket's WAITERS. */
+};
+
+static struct futex_bucket buckets[FUTEX_BUCKETS];
+
+/* Initializes the futex wait queues. */
+void
+futex_init (void) {
+	for (int i = 0; i < FUTEX_BUCKETS; i++) {
+		spinlock_init (&buckets[i].lock);
+		list_init (&buckets[i].waiters);
+	}
+}
+
+/* 유저 주소 UADDR이 가리키는 int의 kernel 주소를 반환하는 함수.
+	정렬되지 않았거나 매핑되지 않은 주소면 null을 반환한다. */
+static int *
+futex_kaddr (const int *uaddr) {
+	if ((uintptr_t) uaddr % sizeof (int) != 0 || !is_user_vaddr (uaddr))
+		return NULL;
+	return pml4_get_page (thread_current ()->pml4, uaddr);
+}
+
+/* KEY에 해당하는 bucket을 반환하는 함수 */
+static struct futex_bucket *
+futex_bucket (uintptr_t key) {
+	return &buckets[hash_int (key / sizeof (int)) % FUTEX_BUCKETS];
+}
+
+/* list_insert_ordered 함수에서 사용하기 위한 함수
+	priority가 높은 waiter가 앞에 오도록 삽입하기 위한 함수 */
+static bool
+waiter_prior (const struct list_elem *a_, const struct list_elem *b_,
+		void *aux UNUSED) {
+	const struct futex_waiter *a = list_entry (a_, struct futex_waiter, elem);
+	const struct futex_waiter *b = list_entry (b_, struct futex_waiter, elem);
+
+	return a->thread->priority > b->thread->priority;
+}
+
+/* If the int at user address UADDR still equals EXPECTED, sleeps
+   until futex_wake() is called on it and returns 0.  Otherwise
+   returns -1 at once.  Also returns -1 if UADDR is not a valid,
+   aligned user address, or if the process is exiting, since
+   futex_wake_process() may already have run. */
+int
+futex_wait (const int *uaddr, int expected) {
+	struct futex_waiter w;
+	struct futex_bucket *b;
+	enum intr_level old_level;
+	int *kaddr = futex_kaddr (uaddr);
+
+	if (kaddr == NULL)
+		return -1;
+
+	w.key = vtop (kaddr);
+	w.thread = thread_current ();
+	b = futex_bucket (w.key);
+
+	old_level = intr_disable ();
+	spin_lock (&b->lock);
+	if (*(volatile int *) kaddr != expected || w.thread->process->exiting) {
+		spin_unlock (&b->lock);
+		intr_set_level (old_level);
+		return -1;
+	}
+	list_insert_ordered (&b->waiters, &w.elem, waiter_prior, NULL);
+	thread_block_locked (&b->lock);
+	intr_set_level (old_level);
+	return 0;
+}
+
+/* Wakes up to N threads sleeping in futex_wait() on the int at
+   user address UADDR, highest priority first.  Returns the
+   number of threads woken, or -1 if UADDR is not a valid,
+   aligned user address. */
+int
+futex_wake (const int *uaddr, int n) {
+	struct futex_bucket *b;
+	struct list_elem *e;
+	enum intr_level old_level;
+	uintptr_t key;
+	int woken = 0;
+	int *kaddr = futex_kaddr (uaddr);
+
+	if (kaddr == NULL)
+		return -1;
+
+	key = vtop (kaddr);
+	b = futex_bucket (key);
+
+	old_level = intr_disable ();
+	spin_lock (&b->lock);
+	for (e = list_begin (&b->waiters); e != list_end (&b->waiters) && woken < n; ) {
+		struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+
+		if (w->key == key) {
+			e = list_remove (e);
+			thread_unblock (w->thread);
+			woken++;
+		} else
+			e = list_next (e);
+	}
+	spin_unlock (&b->lock);
+	thread_maybe_yield ();
+	intr_set_level (old_level);
+	return woken;
+}
+
+/* Wakes every thread of PROC sleeping in futex_wait(), so that a
+   process whose threads are being killed does not leave any of
+   them asleep forever. */
+void
+futex_wake_process (struct process *proc) {
+	enum intr_level old_level = intr_disable ();
+
+	for (int i = 0; i < FUTEX_BUCKETS; i++) {
+		struct futex_bucket *b = &buckets[i];
+		struct list_elem *e;
+
+		spin_lock (&b->lock);
+		for (e = list_begin (&b->waiters); e != list_end (&b->waiters); ) {
+			struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+
+			if (w->thread->process == proc) {
+				e = list_remove (e);
+				thread_unblock (w->thread);
+			} else
+				e = list_next (e);
+		}
+		spin_unlock (&b->lock);
+	}
+	intr_set_level (old_level);
+}
@@ -1,6 +1,8 @@
 #include "userprog/gdt.h"
 #include <debug.h>
+#include <string.h>
 #include "userprog/tss.h"
+#include "threads/cpu.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
@@ -72,19 +74,27 @@ static struct segment_desc gdt[SEL_CNT] = {
 	[7] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
 };
 
-struct desc_ptr gdt_ds = {
-	.size = sizeof(gdt) - 1,
-	.address = (uint64_t) gdt
-};
+/* The GDT of each CPU, a copy of the one above with that CPU's
+   TSS.  A TSS descriptor is marked busy by `ltr', which refuses a
+   busy one, so CPUs cannot share a TSS slot. */
+static struct segment_desc cpu_gdts[NCPU_MAX][SEL_CNT];
 
-/* Sets up a proper GDT.  The bootstrap loader's GDT didn't
-   include user-mode selectors or a TSS, but we need both now. */
+/* Sets up a proper GDT for the current CPU.  The bootstrap
+   loader's GDT didn't include user-mode selectors or a TSS, but
+   we need both now.  Must be called after tss_init(). */
 void
 gdt_init (void) {
 	/* Initialize GDT. */
+	struct segment_desc *gdt_cpu = cpu_gdts[this_cpu ()->id];
 	struct segment_descriptor64 *tss_desc =
-		(struct segment_descriptor64 *) &gdt[SEL_TSS >> 3];
+		(struct segment_descriptor64 *) &gdt_cpu[SEL_TSS >> 3];
 	struct task_state *tss = tss_get ();
+	struct desc_ptr gdt_ds = {
+		.size = sizeof gdt - 1,
+		.address = (uint64_t) gdt_cpu
+	};
+
+	memcpy (gdt_cpu, gdt, sizeof gdt);
 
 	*tss_desc = (struct segment_descriptor64) {
 		.lim_15_0 = (uint64_t) (sizeof (struct task_state)) & 0xffff,
@@ -106,8 +116,9 @@ gdt_init (void) {
 	};
 
 	lgdt (&gdt_ds);
-	/* reload segment registers */
-	asm volatile("movw %%ax, %%gs" :: "a" (SEL_UDSEG));
+	/* reload segment registers.
+	   %gs is left alone, since loading it would clear the GS base
+	   that points to this CPU's struct cpu. */
 	asm volatile("movw %%ax, %%fs" :: "a" (0));
 	asm volatile("movw %%ax, %%es" :: "a" (SEL_KDSEG));
 	asm volatile("movw %%ax, %%ds" :: "a" (SEL_KDSEG));
@@ -18,9 +18,11 @@
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
 #include "intrinsic.h"
+#include "devices/input.h"
 #include "devices/timer.h"
 #include "threads/malloc.h"
 #include "userprog/syscall.h"
+#include "userprog/futex.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
@@ -29,6 +31,24 @@ static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
 static void initd (void *f_name);
 static void __do_fork (void *);
+static bool process_alloc (void);
+static void process_leave (void);
+static bool process_kill_others (void);
+static void stack_slot_free (int slot);
+#ifndef VM
+static bool install_page (void *upage, void *kpage, bool writable);
+#endif
+
+/* fd_node를 할당하는 kmem_cache */
+static struct kmem_cache *fd_node_cache;
+
+/* 프로세스가 사용하는 kmem_cache를 만드는 함수, 부팅 시 한 번 호출 */
+void
+process_cache_init (void) {
+	fd_node_cache = kmem_cache_create ("fd_node", sizeof (struct fd_node), 0, NULL);
+	if (fd_node_cache == NULL)
+		PANIC("fd_node cache creation failed");
+}
 
 /* process의 fd_table을 초기화 하는 함수
 	fd_node를 이중포인터로 사용하여 동적배열로 동작하게 하였으며,
@@ -36,46 +56,53 @@ static void __do_fork (void *);
 	이후 fd_node를 생성할때도 할당해준 포인터를 저장해야 함*/
 static void
 process_fd_init (void) {
-	struct thread *current = thread_current ();
-
-	current->fd_table.fd_limit = FD_LIMIT;
-	current->fd_table.fd_next = FD_NEXT;
-	current->fd_table.fd_node = calloc (current->fd_table.fd_limit, sizeof *current->fd_table.fd_node);
-	if (current->fd_table.fd_node == NULL) PANIC("fd table calloc failed");
-
-	current->fd_table.fd_node[0] = malloc (sizeof *current->fd_table.fd_node[0]);
-	current->fd_table.fd_node[1] = malloc (sizeof *current->fd_table.fd_node[1]);
-	if (current->fd_table.fd_node[0] == NULL || current->fd_table.fd_node[1] == NULL) PANIC("std fd node malloc failed");
-
-	current->fd_table.fd_node[0]->type = FD_STDIN;
-	current->fd_table.fd_node[0]->file = NULL;
-	current->fd_table.fd_node[1]->type = FD_STDOUT;
-	current->fd_table.fd_node[1]->file = NULL;
+	struct fd_table *table = &thread_current ()->process->fd_table;
+
+	table->fd_limit = FD_LIMIT;
+	table->fd_next = FD_NEXT;
+	table->fd_node = calloc (table->fd_limit, sizeof *table->fd_node);
+	if (table->fd_node == NULL) PANIC("fd table calloc failed");
+
+	table->fd_node[0] = kmem_cache_alloc (fd_node_cache);
+	table->fd_node[1] = kmem_cache_alloc (fd_node_cache);
+	if (table->fd_node[0] == NULL || table->fd_node[1] == NULL) PANIC("std fd node malloc failed");
+
+	table->fd_node[0]->type = FD_STDIN;
+	table->fd_node[0]->file = NULL;
+	table->fd_node[0]->refcnt = 1;
+	table->fd_node[1]->type = FD_STDOUT;
+	table->fd_node[1]->file = NULL;
+	table->fd_node[1]->refcnt = 1;
 }
 
 /* process의 fd_table을 초기화 하는 함수
 	초기화를 하는데, 매겨변수로 들어온 스레드의 파일 디스크립터로 복사 */
 static void
 process_fd_duplicate (struct thread *origin) {
-	struct thread *current = thread_current ();
-
-	current->fd_table.fd_limit = FD_LIMIT;
-	current->fd_table.fd_next = FD_NEXT;
-	current->fd_table.fd_node = calloc (current->fd_table.fd_limit, sizeof *current->fd_table.fd_node);
-	if (current->fd_table.fd_node == NULL) PANIC("dup fd table calloc failed");
-
-	for (int i = 0; i < origin->fd_table.fd_limit; i++) {
-		if (origin->fd_table.fd_node[i] != NULL) {
-			current->fd_table.fd_node[i] = malloc (sizeof *current->fd_table.fd_node[i]);
-			if (current->fd_table.fd_node[i] == NULL) PANIC("dup std fd node malloc failed");
-
-			current->fd_table.fd_node[i]->type = origin->fd_table.fd_node[i]->type;
-			if (origin->fd_table.fd_node[i]->file != NULL)
-				current->fd_table.fd_node[i]->file = file_duplicate (origin->fd_table.fd_node[i]->file);
+	struct fd_table *table = &thread_current ()->process->fd_table;
+	struct fd_table *origin_table = &origin->process->fd_table;
+
+	table->fd_limit = FD_LIMIT;
+	table->fd_next = FD_NEXT;
+	table->fd_node = calloc (table->fd_limit, sizeof *table->fd_node);
+	if (table->fd_node == NULL) PANIC("dup fd table calloc failed");
+
+	/* 부모 프로세스의 다른 스레드가 복사 도중에 close하지 못하도록 부모의 fd_lock을 잡는다 */
+	lock_acquire (&origin->process->fd_lock);
+	for (int i = 0; i < origin_table->fd_limit; i++) {
+		if (origin_table->fd_node[i] != NULL) {
+			table->fd_node[i] = kmem_cache_alloc (fd_node_cache);
+			if (table->fd_node[i] == NULL) PANIC("dup std fd node malloc failed");
+
+			table->fd_node[i]->type = origin_table->fd_node[i]->type;
+			table->fd_node[i]->refcnt = 1;
+			if (origin_table->fd_node[i]->file != NULL)
+				table->fd_node[i]->file = file_duplicate (origin_table->fd_node[i]->file);
 			else
-				current->fd_table.fd_node[i]->file = NULL;
+				table->fd_node[i]->file = NULL;
 		}
 	}
+	lock_release (&origin->process->fd_lock);
 }
 
 /* tid_t로 현재 프로세스에서 자식 프로세스가 있는지 찾는 함수
@@ -92,11 +119,34 @@ process_get_child (tid_t child_tid) {
 	return NULL;
 }
 
+/* 현재 스레드를 첫 스레드(main)로 하는 process를 할당하는 함수
+	메모리가 부족하면 false를 반환 */
+static bool
+process_alloc (void) {
+	struct thread *current = thread_current ();
+	struct process *proc = calloc (1, sizeof *proc);
+
+	if (proc == NULL)
+		return false;
+
+	proc->refcnt = 1;
+	proc->main = current;
+	list_init (&proc->threads);
+	lock_init (&proc->fd_lock);
+	sema_init (&proc->alone, 0);
+#ifdef VM
+	supplemental_page_table_init (&proc->spt);
+#endif
+	current->process = proc;
+	return true;
+}
+
 /* General process initializer for initd and other process. 
 initd 및 기타 프로세스를 위한 일반 프로세스 초기화 함수입니다.*/
 static void
 process_init (void) {
-	struct thread *current = thread_current ();
+	if (!process_alloc ())
+		PANIC("process alloc failed");
 
 	process_fd_init ();
 }
@@ -104,8 +154,6 @@ process_init (void) {
 /* 매개변수로 들어온 프로세스를 복제해서 초기화 하는 함수 */
 static void
 process_duplicate (struct thread *origin) {
-	struct thread *current = thread_current ();
-
 	process_fd_duplicate (origin);
 }
 
@@ -114,16 +162,16 @@ process_duplicate (struct thread *origin) {
 static int
 process_get_fd (void) {
 	struct thread *current = thread_current ();
-	int empty_fd = current->fd_table.fd_next;
+	int empty_fd = current->process->fd_table.fd_next;
 
 	do {
-		if (current->fd_table.fd_node[empty_fd] == NULL) {
-			current->fd_table.fd_next = empty_fd;
+		if (current->process->fd_table.fd_node[empty_fd] == NULL) {
+			current->process->fd_table.fd_next = empty_fd;
 			return empty_fd;
 		}
 		else
-			empty_fd = (empty_fd == current->fd_table.fd_limit) ? 0 : ++empty_fd;
-	}	while (empty_fd != current->fd_table.fd_next);
+			empty_fd = (empty_fd == current->process->fd_table.fd_limit) ? 0 : ++empty_fd;
+	}	while (empty_fd != current->process->fd_table.fd_next);
 
 	return -1;
 }
@@ -133,30 +181,67 @@ process_get_fd (void) {
 static struct fd_node*
 process_check_fd (int check_fd) {
 	struct thread *current = thread_current ();
-	if (0 <= check_fd && check_fd < current->fd_table.fd_limit) {
-		if (current->fd_table.fd_node[check_fd] != NULL) {
-			return current->fd_table.fd_node[check_fd];
+	if (0 <= check_fd && check_fd < current->process->fd_table.fd_limit) {
+		if (current->process->fd_table.fd_node[check_fd] != NULL) {
+			return current->process->fd_table.fd_node[check_fd];
 		}
 	}
 	return NULL;
 }
 
+/* FD에 들어있는 fd_node의 참조를 하나 늘려서 반환하는 함수.
+	같은 프로세스의 다른 스레드가 그 사이에 close하더라도 process_fd_put을
+	부를 때까지 fd_node와 파일이 해제되지 않는다. 빈 fd면 NULL을 반환 */
+static struct fd_node *
+process_fd_get (int fd) {
+	struct process *proc = thread_current ()->process;
+	struct fd_node *node;
+
+	lock_acquire (&proc->fd_lock);
+	if ((node = process_check_fd (fd)) != NULL)
+		node->refcnt++;
+	lock_release (&proc->fd_lock);
+	return node;
+}
+
+/* NODE의 참조를 하나 줄이는 함수. 마지막 참조였다면 파일을 닫고 NODE를 해제 */
+static void
+process_fd_put (struct fd_node *node) {
+	struct process *proc = thread_current ()->process;
+	bool last;
+
+	lock_acquire (&proc->fd_lock);
+	last = --node->refcnt == 0;
+	lock_release (&proc->fd_lock);
+
+	if (last) {
+		file_close (node->file);
+		kmem_cache_free (fd_node_cache, node);
+	}
+}
+
 /* 매개변수로 들어온 문자열로 해당 파일을 오픈하는 함수
 	오픈이 가능한 경우, 오픈했던 fd 인덱스를 반환, 안되면 -1 반환 */
 int
 process_file_open (const char *file_name) {
-	struct thread *current = thread_current ();
+	struct process *proc = thread_current ()->process;
+	struct fd_node **slot;
 	struct file *open_file;
 	int return_fd;
 
+	/* 같은 프로세스의 다른 스레드와 같은 fd를 잡지 않도록 fd_lock을 잡고 할당 */
+	lock_acquire (&proc->fd_lock);
 	if ((return_fd = process_get_fd ()) != -1 && (open_file = filesys_open (file_name)) != NULL) {
-		current->fd_table.fd_node[return_fd] = malloc (sizeof *current->fd_table.fd_node[return_fd]);
-		if (current->fd_table.fd_node[return_fd] == NULL) PANIC("file open malloc failed");
-		current->fd_table.fd_node[return_fd]->file = open_file;
-		current->fd_table.fd_node[return_fd]->type = FD_FILE;
-		return return_fd;
-	}
-	return -1;
+		slot = &proc->fd_table.fd_node[return_fd];
+		*slot = kmem_cache_alloc (fd_node_cache);
+		if (*slot == NULL) PANIC("file open malloc failed");
+		(*slot)->file = open_file;
+		(*slot)->type = FD_FILE;
+		(*slot)->refcnt = 1;
+	} else
+		return_fd = -1;
+	lock_release (&proc->fd_lock);
+	return return_fd;
 }
 
 /* 매개변수로 들어온 fd로 해당 파일을 size를 반환하는 함수
@@ -164,11 +249,26 @@ process_file_open (const char *file_name) {
 int
 process_file_length (int fd) {
 	struct fd_node *node;
+	int length = -1;
 
-	if ((node = process_check_fd (fd)) && node->type == FD_FILE) {
-		return file_length (node->file);
+	if ((node = process_fd_get (fd)) != NULL) {
+		if (node->type == FD_FILE)
+			length = file_length (node->file);
+		process_fd_put (node);
 	}
-	return -1;
+	return length;
+}
+
+/* 키보드에서 한 글자를 읽어 반환하는 함수. 입력을 기다리는 동안 같은 프로세스의
+	다른 스레드가 exit()이나 exec()을 하면 process_kill_siblings()의 sema_kill()로
+	깨어나 -1을 반환한다 */
+static int
+process_getc (void) {
+	uint8_t key;
+
+	if (!input_getc_killable (&key))
+		return -1;
+	return key;
 }
 
 /* 매개변수로 들어온 fd로 해당 파일을 size 만큼 읽는 함수
@@ -176,14 +276,16 @@ process_file_length (int fd) {
 int
 process_file_read (int fd, void *buffer, unsigned size) {
 	struct fd_node *node;
+	int bytes_read = -1;
 
-	if (node = process_check_fd (fd)) {
+	if ((node = process_fd_get (fd)) != NULL) {
 		if (node->type == FD_FILE)
-			return file_read (node->file, buffer, size);
+			bytes_read = file_read (node->file, buffer, size);
 		else if (node->type == FD_STDIN)
-			return input_getc ();
+			bytes_read = process_getc ();
+		process_fd_put (node);
 	}
-	return -1;
+	return bytes_read;
 }
 
 /* 매개변수로 들어온 fd로 해당 파일을 size 만큼 작성하는 함수
@@ -191,16 +293,18 @@ process_file_read (int fd, void *buffer, unsigned size) {
 int
 process_file_write (int fd, const void *buffer, unsigned size) {
 	struct fd_node *node;
+	int bytes_written = -1;
 
-	if (node = process_check_fd (fd)) {
+	if ((node = process_fd_get (fd)) != NULL) {
 		if (node->type == FD_FILE)
-			return file_write (node->file, buffer, size);
+			bytes_written = file_write (node->file, buffer, size);
 		else if (node->type == FD_STDOUT) {
 			putbuf (buffer, size);
-			return size;
+			bytes_written = size;
 		}
+		process_fd_put (node);
 	}
-	return -1;
+	return bytes_written;
 }
 
 /* 현재 프로세스의 파일디스크립터에 해당 fd의 pos를 업데이트 하는 함수 */
@@ -208,29 +312,42 @@ void
 process_file_seek (int fd, unsigned position) {
 	struct fd_node *node;
 
-	if (node = process_check_fd (fd))
-		file_seek (node->file, position);
+	if ((node = process_fd_get (fd)) != NULL) {
+		if (node->type == FD_FILE)
+			file_seek (node->file, position);
+		process_fd_put (node);
+	}
 }
 
-/* 열려진 파일 fd에서 읽히거나 써질 다음 바이트의 위치를 반환 */
+/* 열려진 파일 fd에서 읽히거나 써질 다음 바이트의 위치를 반환
+	열린 파일이 아닌 fd면 -1을 반환 */
 unsigned
 process_file_tell (int fd) {
 	struct fd_node *node;
+	unsigned position = -1;
 
-	if (node = process_check_fd (fd))
-		return file_tell (node->file);
+	if ((node = process_fd_get (fd)) != NULL) {
+		if (node->type == FD_FILE)
+			position = file_tell (node->file);
+		process_fd_put (node);
+	}
+	return position;
 }
 
-/* 매개변수로 들어온 fd에 파일이 있다면 close하는 함수 */
+/* 매개변수로 들어온 fd에 파일이 있다면 close하는 함수
+	다른 스레드가 아직 쓰고 있는 파일은 그 스레드가 process_fd_put을 할 때 닫힌다 */
 void
 process_file_close (int fd) {
+	struct process *proc = thread_current ()->process;
 	struct fd_node *node;
 
-	if (node = process_check_fd (fd)) {
-		thread_current ()->fd_table.fd_node[fd] = NULL;
-		file_close (node->file);
-		free (node);
-	}
+	lock_acquire (&proc->fd_lock);
+	if ((node = process_check_fd (fd)) != NULL)
+		proc->fd_table.fd_node[fd] = NULL;
+	lock_release (&proc->fd_lock);
+
+	if (node != NULL)
+		process_fd_put (node);
 }
 
 /* Starts the first userland program, called "initd", loaded from FILE_NAME.
@@ -269,10 +386,6 @@ process_create_initd (const char *file_name) {
 /* 첫 번째 사용자 프로세스를 실행하는 스레드 함수입니다. */
 static void
 initd (void *f_name) {
-#ifdef VM
-	supplemental_page_table_init (&thread_current ()->spt);
-#endif
-
 	process_init ();
 
 	if (process_exec (f_name) < 0)
@@ -368,6 +481,9 @@ __do_fork (void *aux) {
 	memcpy (&if_, parent_if, sizeof (struct intr_frame));
 	if_.R.rax = 0;
 
+	if (!process_alloc ())
+		goto error;
+
 	/* 2. Duplicate PT */
 	current->pml4 = pml4_create();
 	if (current->pml4 == NULL)
@@ -375,8 +491,7 @@ __do_fork (void *aux) {
 
 	process_activate (current);
 #ifdef VM
-	supplemental_page_table_init (&current->spt);
-	if (!supplemental_page_table_copy (&current->spt, &parent->spt))
+	if (!supplemental_page_table_copy (&current->process->spt, &parent->process->spt))
 		goto error;
 #else
 	if (!pml4_for_each (parent->pml4, duplicate_pte, parent))
@@ -384,8 +499,8 @@ __do_fork (void *aux) {
 #endif
 
 	/* fork니까 부모의 스레드를 복사 */
-	current->current_file = file_duplicate (parent->current_file);
-	file_deny_write (current->current_file);
+	current->process->current_file = file_duplicate (parent->process->current_file);
+	file_deny_write (current->process->current_file);
 	process_duplicate (parent);
 
 	/* Finally, switch to the newly created process. */
@@ -421,6 +536,12 @@ process_exec (void *f_name) {
 	_if.cs = SEL_UCSEG;
 	_if.eflags = FLAG_IF | FLAG_MBS;
 
+	/* 다른 스레드들이 주소 공간을 쓰고 있으면 먼저 모두 종료시킨다 */
+	if (!process_kill_others ()) {
+		palloc_free_page (file_name);
+		return -1;
+	}
+
 	/* We first kill the current context */
 	process_cleanup ();
 
@@ -463,9 +584,11 @@ process_wait (tid_t child_tid UNUSED) {
 		struct child_state *child_elem = list_entry(elem, struct child_state, elem);
 
 		if (child_tid == child_elem->cheild_tid) {
-			if (child_elem->is_dying == false) {
-				sema_down (&child_elem->cheild_ptr->exit_sema);
-			}
+			/* 같은 프로세스의 다른 스레드가 exit()이나 exec()을 하면 자식을 더 기다리지 않는다.
+				자식 상태는 리스트에 남겨 두고 process_exit에서 정리한다 */
+			if (child_elem->is_dying == false
+					&& !sema_down_killable (&child_elem->cheild_ptr->exit_sema))
+				return -1;
 
 			int exit_state = child_elem->exit_state;
 			list_remove (elem);
@@ -481,10 +604,19 @@ process_wait (tid_t child_tid UNUSED) {
 void
 process_exit (void) {
 	struct thread *curr = thread_current ();
-	struct fd_node *file_ptr;
+	struct process *proc = curr->process;
+	struct list *states;
+	enum intr_level old_level;
+
+	/* thread_create 시스템 콜로 만든 스레드는 같은 프로세스의 threads 리스트에,
+		그 외에는 부모 프로세스의 자식 리스트에 종료 상태를 남긴다 */
+	if (proc != NULL && proc->main != curr)
+		states = &proc->threads;
+	else
+		states = &curr->process_parent->process_child_list;
 
-	/* 부모 프로세스에서 현재 프로세스의 list를 찾고 값을 업데이트 하고 exit */
-	for (struct list_elem *elem = list_begin(&curr->process_parent->process_child_list); elem != list_end(&curr->process_parent->process_child_list); elem = list_next (elem)) {
+	old_level = intr_disable ();
+	for (struct list_elem *elem = list_begin(states); elem != list_end(states); elem = list_next (elem)) {
 		struct child_state *child_elem = list_entry(elem, struct child_state, elem);
 
 		if (child_elem->cheild_ptr == curr) {
@@ -493,16 +625,14 @@ process_exit (void) {
 		}
 	}
 
-	/* 현재 프로세스가 갖고있는 fd_table을 모두 닫고 할장 해제 */
-	for (int i = 0; i < curr->fd_table.fd_limit; i++) {
-		if (file_ptr = process_check_fd (i)) {
-			process_file_close (i);
-		}
+	/* 끝나는 스레드의 CPU 사용량은 process에 모아 둔다. 이후로는 process_getrusage가
+		이 스레드를 따로 세지 않는다 */
+	if (proc != NULL) {
+		thread_rusage_add (curr, &proc->ru);
+		if (proc->main == curr)
+			proc->main = NULL;
 	}
-	free (curr->fd_table.fd_node);
-
-	/* 프로세스 자체가 열고있는 파일 close */
-	file_close (curr->current_file);
+	intr_set_level (old_level);
 
 	for (struct list_elem *elem = list_begin(&curr->process_child_list); elem != list_end(&curr->process_child_list); elem = list_begin(&curr->process_child_list)) {
 		struct child_state *child_elem = list_entry(elem, struct child_state, elem);
@@ -513,7 +643,60 @@ process_exit (void) {
 	/* exit 하면서 부모 스레드가 이 스레드가 끝날때까지 대기하기 위해 sema_down을 할 경우, sema_up을 실행 */
 	sema_up (&curr->exit_sema);
 
-	process_cleanup ();	
+	process_leave ();
+}
+
+/* 현재 스레드를 process에서 빼는 함수
+	마지막 스레드라면 fd_table, 실행 파일, 주소 공간 등 공유 자원을 모두 해제하고,
+	아니라면 자기 유저 스택만 반납하고 주소 공간에서 떨어져 나온다 */
+static void
+process_leave (void) {
+	struct thread *curr = thread_current ();
+	struct process *proc = curr->process;
+	enum intr_level old_level;
+	uint64_t *pml4;
+	int refcnt;
+
+	if (proc == NULL) {
+		process_cleanup ();
+		return;
+	}
+
+	if (curr->stack_slot >= 0)
+		stack_slot_free (curr->stack_slot);
+
+	/* 다른 스레드가 주소 공간을 해제할 수 있으므로 refcnt를 줄이기 전에 떼어낸다 */
+	pml4 = curr->pml4;
+	curr->pml4 = NULL;
+	pml4_activate (NULL);
+	curr->process = NULL;
+
+	old_level = intr_disable ();
+	refcnt = --proc->refcnt;
+	if (refcnt == 1)
+		sema_up (&proc->alone);
+	intr_set_level (old_level);
+	if (refcnt > 0)
+		return;
+
+	/* 마지막 스레드: 공유 자원 정리 */
+	curr->process = proc;
+	curr->pml4 = pml4;
+
+	/* 현재 프로세스가 갖고있는 fd_table을 모두 닫고 할장 해제 */
+	for (int i = 0; i < proc->fd_table.fd_limit; i++)
+		process_file_close (i);
+	free (proc->fd_table.fd_node);
+
+	/* 프로세스 자체가 열고있는 파일 close */
+	file_close (proc->current_file);
+
+	process_cleanup ();
+
+	while (!list_empty (&proc->threads))
+		free (list_entry (list_pop_front (&proc->threads), struct child_state, elem));
+	curr->process = NULL;
+	free (proc);
 }
 
 /* Free the current process's resources. */
@@ -522,7 +705,7 @@ process_cleanup (void) {
 	struct thread *curr = thread_current ();
 
 #ifdef VM
-	supplemental_page_table_kill (&curr->spt);
+	supplemental_page_table_kill (&curr->process->spt);
 #endif
 
 	uint64_t *pml4;
@@ -554,6 +737,322 @@ process_activate (struct thread *next) {
 	tss_update (next);
 }
 
+/* PROC의 현재 스레드가 아닌 스레드들을 모두 끝나게 하는 함수. PROC->exiting을
+	세운 뒤에 호출한다. 스레드들은 유저 모드로 돌아가기 직전에 끝나므로,
+	끝이 없을 수 있는 대기(futex, wait(), 키보드 입력)에 잠든 스레드는 깨운다.
+	나머지 대기(lock, 디스크, timer_sleep, 같이 끝나는 스레드의 join)는 곧 끝난다 */
+void
+process_kill_siblings (struct process *proc) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level = intr_disable ();
+
+	if (proc->main != NULL && proc->main != curr)
+		sema_kill (proc->main);
+	for (struct list_elem *elem = list_begin(&proc->threads); elem != list_end(&proc->threads); elem = list_next (elem)) {
+		struct child_state *child_elem = list_entry(elem, struct child_state, elem);
+
+		if (!child_elem->is_dying && child_elem->cheild_ptr != curr)
+			sema_kill (child_elem->cheild_ptr);
+	}
+	intr_set_level (old_level);
+	futex_wake_process (proc);
+}
+
+/* 같은 프로세스의 다른 스레드를 모두 종료시키고 현재 스레드만 남을 때까지 기다리는 함수
+	exec에서 주소 공간을 갈아엎기 전에 호출한다. 다른 스레드가 남아 있는데
+	현재 스레드가 main이 아니면 (부모에게 보고할 스레드가 사라지므로) false를 반환.
+	다른 스레드가 exit()을 불렀다면 그 종료를 취소하지 않도록 역시 false를 반환하고,
+	현재 스레드는 유저 모드로 돌아가기 전에 그 종료 상태로 끝난다 */
+static bool
+process_kill_others (void) {
+	struct thread *curr = thread_current ();
+	struct process *proc = curr->process;
+	enum intr_level old_level;
+
+	if (proc == NULL || proc->refcnt == 1)
+		return true;
+	if (proc->main != curr)
+		return false;
+
+	old_level = intr_disable ();
+	if (proc->exiting) {
+		intr_set_level (old_level);
+		return false;
+	}
+	proc->exit_status = -1;
+	proc->exiting = true;
+	intr_set_level (old_level);
+
+	process_kill_siblings (proc);
+	while (proc->refcnt > 1)
+		sema_down (&proc->alone);
+
+	/* 기다리는 동안 다른 스레드가 exit()을 불렀을 수 있다 */
+	old_level = intr_disable ();
+	if (proc->exit_called) {
+		intr_set_level (old_level);
+		return false;
+	}
+	proc->exiting = false;
+	intr_set_level (old_level);
+
+	while (!list_empty (&proc->threads))
+		free (list_entry (list_pop_front (&proc->threads), struct child_state, elem));
+	return true;
+}
+
+/* SLOT번 스택 슬롯의 가장 위 페이지 주소를 반환 */
+static void *
+stack_slot_page (int slot) {
+	return (void *) ((uintptr_t) THREAD_STACK_TOP - slot * THREAD_STACK_GAP - PGSIZE);
+}
+
+/* SLOT번 스택 슬롯에 현재 주소 공간의 유저 스택 페이지를 하나 매핑하는 함수 */
+static bool
+stack_slot_install (int slot) {
+	void *upage = stack_slot_page (slot);
+#ifdef VM
+	return vm_alloc_page (VM_ANON | VM_MARKER_0, upage, true)
+		&& vm_claim_page (upage);
+#else
+	void *kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+
+	if (kpage == NULL)
+		return false;
+	if (!install_page (upage, kpage, true)) {
+		palloc_free_page (kpage);
+		return false;
+	}
+	return true;
+#endif
+}
+
+/* SLOT번 스택 슬롯의 페이지를 해제하고 슬롯을 반납하는 함수 */
+static void
+stack_slot_free (int slot) {
+	struct thread *curr = thread_current ();
+	struct process *proc = curr->process;
+	void *upage = stack_slot_page (slot);
+	enum intr_level old_level;
+#ifdef VM
+	struct page *page = spt_find_page (&proc->spt, upage);
+
+	if (page != NULL)
+		spt_remove_page (&proc->spt, page);
+#else
+	void *kpage = pml4_get_page (curr->pml4, upage);
+
+	if (kpage != NULL) {
+		pml4_clear_page (curr->pml4, upage);
+		palloc_free_page (kpage);
+	}
+#endif
+
+	old_level = intr_disable ();
+	proc->stack_slots &= ~(1u << slot);
+	intr_set_level (old_level);
+	if (curr->stack_slot == slot)
+		curr->stack_slot = -1;
+}
+
+/* process_thread_create가 새 스레드에게 넘기는 시작 정보.
+	만드는 스레드의 스택에 있으므로 새 스레드가 복사를 끝낼 때까지 유지된다 */
+struct user_thread_start {
+	struct intr_frame if_;              /* 유저 모드 첫 진입 컨텍스트 */
+	struct process *proc;               /* 합류할 프로세스 */
+	uint64_t *pml4;                     /* 공유할 주소 공간 */
+	int slot;                           /* 유저 스택 슬롯 */
+	struct semaphore ready;             /* 상태가 threads 리스트로 옮겨짐 */
+	struct semaphore done;              /* 새 스레드가 시작 정보를 복사함 */
+};
+
+/* A thread function that enters user mode in an existing process. */
+static void
+start_user_thread (void *aux) {
+	struct user_thread_start *start = aux;
+	struct thread *curr = thread_current ();
+	struct intr_frame if_;
+
+	sema_down (&start->ready);
+	curr->process = start->proc;
+	curr->pml4 = start->pml4;
+	curr->stack_slot = start->slot;
+	memcpy (&if_, &start->if_, sizeof if_);
+	sema_up (&start->done);
+
+	process_activate (curr);
+	do_iret (&if_);
+	NOT_REACHED ();
+}
+
+/* Starts a new thread in the current process that runs ENTRY in
+   user mode with ARG0 and ARG1 as its first two arguments, on a
+   fresh one-page user stack.  The thread shares the address
+   space and the open files of the process.  Returns the new
+   thread's tid, or TID_ERROR if no stack slot, memory or thread
+   is available. */
+tid_t
+process_thread_create (void *entry, void *arg0, void *arg1) {
+	struct thread *curr = thread_current ();
+	struct process *proc = curr->process;
+	struct user_thread_start start;
+	struct child_state *state;
+	enum intr_level old_level;
+	tid_t tid;
+	int slot;
+
+	/* 빈 스택 슬롯을 잡고, 만드는 동안 프로세스가 해제되지 않도록 refcnt를 올린다 */
+	old_level = intr_disable ();
+	for (slot = 0; slot < THREAD_STACK_SLOTS; slot++)
+		if ((proc->stack_slots & (1u << slot)) == 0)
+			break;
+	if (slot == THREAD_STACK_SLOTS || proc->exiting) {
+		intr_set_level (old_level);
+		return TID_ERROR;
+	}
+	proc->stack_slots |= 1u << slot;
+	proc->refcnt++;
+	intr_set_level (old_level);
+
+	if (!stack_slot_install (slot))
+		goto error;
+
+	memset (&start.if_, 0, sizeof start.if_);
+	start.if_.rip = (uintptr_t) entry;
+	start.if_.R.rdi = (uint64_t) arg0;
+	start.if_.R.rsi = (uint64_t) arg1;
+	/* 함수가 call로 불린 직후처럼 rsp + 8이 16바이트 정렬되도록 맞춘다 */
+	start.if_.rsp = (uintptr_t) stack_slot_page (slot) + PGSIZE - sizeof (void *);
+	start.if_.ds = start.if_.es = start.if_.ss = SEL_UDSEG;
+	start.if_.cs = SEL_UCSEG;
+	start.if_.eflags = FLAG_IF | FLAG_MBS;
+	start.proc = proc;
+	start.pml4 = curr->pml4;
+	start.slot = slot;
+	sema_init (&start.ready, 0);
+	sema_init (&start.done, 0);
+
+	tid = thread_create (curr->name, curr->base_priority, start_user_thread, &start);
+	if (tid == TID_ERROR)
+		goto error;
+
+	/* thread_create가 현재 스레드의 자식 리스트에 넣은 상태를 프로세스의 threads로 옮겨
+		wait()이 아니라 같은 프로세스의 thread_join()으로만 거둘 수 있게 한다 */
+	old_level = intr_disable ();
+	state = process_get_child (tid);
+	list_remove (&state->elem);
+	list_push_back (&proc->threads, &state->elem);
+	intr_set_level (old_level);
+
+	sema_up (&start.ready);
+	sema_down (&start.done);
+	return tid;
+
+error:
+	stack_slot_free (slot);
+	old_level = intr_disable ();
+	if (--proc->refcnt == 1)
+		sema_up (&proc->alone);
+	intr_set_level (old_level);
+	return TID_ERROR;
+}
+
+/* Waits for thread TID of the current process to exit and returns
+   the status it passed to thread_exit(), or -1 if it was killed.
+   Returns -1 at once if TID is not a thread created in this
+   process with process_thread_create(), has already been joined,
+   or is the calling thread. */
+int
+process_thread_join (tid_t tid) {
+	struct thread *curr = thread_current ();
+	struct process *proc = curr->process;
+	enum intr_level old_level;
+	int exit_state = -1;
+
+	if (tid == curr->tid || tid == TID_ERROR)
+		return -1;
+
+	/* is_dying 확인과 sema_down 사이에 대상 스레드가 끝나 사라지지 않도록
+		인터럽트를 끈 채로 기다린다 */
+	old_level = intr_disable ();
+	for (struct list_elem *elem = list_begin(&proc->threads); elem != list_end(&proc->threads); elem = list_next (elem)) {
+		struct child_state *child_elem = list_entry(elem, struct child_state, elem);
+
+		if (tid == child_elem->cheild_tid) {
+			/* 끝나는 스레드는 cheild_ptr로 상태를 찾으므로 리스트에 남겨 두되,
+				같은 tid를 두 번 join하지 못하게 tid를 지운다 */
+			child_elem->cheild_tid = TID_ERROR;
+			if (child_elem->is_dying == false)
+				sema_down (&child_elem->cheild_ptr->exit_sema);
+			exit_state = child_elem->exit_state;
+			list_remove (elem);
+			free (child_elem);
+			break;
+		}
+	}
+	intr_set_level (old_level);
+	return exit_state;
+}
+
+/* Ends the calling thread with STATUS, to be collected by
+   process_thread_join().  The process's initial thread cannot
+   leave alone, so for it this is the same as exit(). */
+void
+process_thread_exit (int status) {
+	struct thread *curr = thread_current ();
+
+	if (curr->process->main == curr)
+		sys_exit (status);
+	curr->exit_status = status;
+	thread_exit ();
+}
+
+/* 같은 프로세스의 다른 스레드가 exit()을 호출했다면, 유저 모드로 돌아가지 않고
+	그 종료 상태로 현재 스레드를 끝내는 함수
+	시스템 콜과 인터럽트가 유저 모드로 돌아가기 직전에 호출된다 */
+void
+process_check_exiting (void) {
+	struct thread *curr = thread_current ();
+
+	if (curr->process != NULL && curr->process->exiting) {
+		intr_enable ();
+		curr->exit_status = curr->process->exit_status;
+		thread_exit ();
+	}
+}
+
+/* Stores in RU the CPU usage selected by WHO: RUSAGE_THREAD for
+   the calling thread, RUSAGE_SELF for all threads of the process,
+   including those that have exited.  Returns 0 on success, -1 if
+   WHO is not one of these. */
+int
+process_getrusage (int who, struct rusage *ru) {
+	struct thread *curr = thread_current ();
+	struct process *proc = curr->process;
+	enum intr_level old_level;
+
+	memset (ru, 0, sizeof *ru);
+	if (who == RUSAGE_THREAD || (who == RUSAGE_SELF && proc == NULL)) {
+		thread_rusage_add (curr, ru);
+		return 0;
+	}
+	if (who != RUSAGE_SELF)
+		return -1;
+
+	old_level = intr_disable ();
+	*ru = proc->ru;
+	if (proc->main != NULL)
+		thread_rusage_add (proc->main, ru);
+	for (struct list_elem *elem = list_begin(&proc->threads); elem != list_end(&proc->threads); elem = list_next (elem)) {
+		struct child_state *child_elem = list_entry(elem, struct child_state, elem);
+
+		if (!child_elem->is_dying)
+			thread_rusage_add (child_elem->cheild_ptr, ru);
+	}
+	intr_set_level (old_level);
+	return 0;
+}
+
 /* We load ELF binaries.  The following definitions are taken
  * from the ELF specification, [ELF1], more-or-less verbatim.  */
 
@@ -643,13 +1142,13 @@ load (const char *file_name, struct intr_frame *if_) {
 		goto done;
 	}
 
-	if (t->current_file == NULL) {
-		t->current_file = file;
+	if (t->process->current_file == NULL) {
+		t->process->current_file = file;
 		file_deny_write (file);
 	}
 	else {
-		file_allow_write (t->current_file);
-		t->current_file = file;
+		file_allow_write (t->process->current_file);
+		t->process->current_file = file;
 		file_deny_write (file);
 	}
 
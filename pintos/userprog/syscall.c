@@ -1,14 +1,17 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
 #include <syscall-nr.h>
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/loader.h"
+#include "threads/trace.h"
 #include "userprog/gdt.h"
 #include "threads/flags.h"
 #include "intrinsic.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "userprog/process.h"
+#include "userprog/futex.h"
 
 void syscall_entry (void);
 void syscall_handler (struct intr_frame *);
@@ -28,6 +31,14 @@ void syscall_handler (struct intr_frame *);
 
 void
 syscall_init (void) {
+	syscall_init_cpu ();
+	futex_init ();
+}
+
+/* Points the current CPU's `syscall' instruction at
+   syscall_entry.  Each CPU has its own MSRs. */
+void
+syscall_init_cpu (void) {
 	write_msr(MSR_STAR, ((uint64_t)SEL_UCSEG - 0x10) << 48  |
 			((uint64_t)SEL_KCSEG) << 32);
 	write_msr(MSR_LSTAR, (uint64_t) syscall_entry);
@@ -52,6 +63,9 @@ check_address (void *addr) {
 void
 syscall_handler (struct intr_frame *f UNUSED) {
 	// TODO: Your implementation goes here.
+	bkl_acquire ();
+	TRACE (TRACE_SYSCALL, f->R.rax);
+	thread_charge_user ();
 	switch (f->R.rax)
 	{
 		case SYS_HALT:
@@ -96,11 +110,43 @@ syscall_handler (struct intr_frame *f UNUSED) {
 		case SYS_CLOSE:
 			sys_close(f->R.rdi);
 			break;
+		case SYS_LOCKSTAT:
+			f->R.rax = sys_lockstat ((struct lockstat *) f->R.rdi, f->R.rsi);
+			break;
+		case SYS_FUTEX_WAIT:
+			f->R.rax = sys_futex_wait ((const int *) f->R.rdi, f->R.rsi);
+			break;
+		case SYS_FUTEX_WAKE:
+			f->R.rax = sys_futex_wake ((const int *) f->R.rdi, f->R.rsi);
+			break;
+		case SYS_THREAD_CREATE:
+			f->R.rax = sys_thread_create ((void *) f->R.rdi, (void *) f->R.rsi, (void *) f->R.rdx);
+			break;
+		case SYS_THREAD_JOIN:
+			f->R.rax = sys_thread_join (f->R.rdi);
+			break;
+		case SYS_THREAD_EXIT:
+			sys_thread_exit (f->R.rdi);
+			break;
+		case SYS_GETRUSAGE:
+			f->R.rax = sys_getrusage (f->R.rdi, (struct rusage *) f->R.rsi);
+			break;
+		case SYS_SCHED_SETSCHEDULER:
+			f->R.rax = sys_sched_setscheduler (f->R.rdi, f->R.rsi);
+			break;
 		default:
 			printf ("system call exiting\n");
 			thread_exit ();
 			break;
 	}
+
+	thread_charge_system ();
+
+	/* 같은 프로세스의 다른 스레드가 exit() 했다면 유저 모드로 돌아가지 않는다 */
+	process_check_exiting ();
+
+	/* sysretq까지 인터럽트를 끈 채로 lock을 놓는다 */
+	bkl_exit ();
 }
 
 void
@@ -110,8 +156,18 @@ sys_halt (void) {
 
 void
 sys_exit (int status) {
+	struct process *proc = thread_current ()->process;
+
 	printf ("%s: exit(%d)\n", thread_name (), status);
 	thread_current ()->exit_status = status;
+
+	/* 같은 프로세스의 다른 스레드들도 이 상태로 종료시킨다 */
+	if (proc != NULL && !proc->exit_called) {
+		proc->exit_status = status;
+		proc->exit_called = true;
+		proc->exiting = true;
+		process_kill_siblings (proc);
+	}
 	thread_exit ();
 }
 
@@ -124,8 +180,11 @@ sys_fork (const char *thread_name, struct intr_frame *f) {
 int 
 sys_exec (const char *cmd_line){
 	check_address(cmd_line);
-	if (process_exec (cmd_line) < 0)
+	if (process_exec (cmd_line) < 0) {
+		/* 다른 스레드의 exit() 때문에 실패했다면 그 종료 상태로 끝난다 */
+		process_check_exiting ();
 		sys_exit (-1);
+	}
 }
 
 int
@@ -181,4 +240,74 @@ sys_tell (int fd) {
 void 
 sys_close (int fd){
 	process_file_close (fd);
-}
\ No newline at end of file
+}
+
+/* 커널 lock들의 경합 통계를 최대 CNT개까지 BUF에 복사하고,
+	복사한 개수를 반환합니다. LOCKSTAT 없이 빌드된 커널에서는 0을 반환합니다. */
+int
+sys_lockstat (struct lockstat *buf, int cnt) {
+	struct lockstat st;
+	int i;
+
+	for (i = 0; i < cnt && lock_stat_get (i, &st); i++) {
+		check_address (&buf[i]);
+		check_address ((uint8_t *) &buf[i + 1] - 1);
+		buf[i] = st;
+	}
+	return i;
+}
+
+/* WHO가 가리키는 CPU 사용량을 유저 버퍼 RU에 복사합니다.
+	성공하면 0, WHO가 잘못되었으면 -1을 반환합니다. */
+int
+sys_getrusage (int who, struct rusage *ru) {
+	struct rusage usage;
+
+	check_address (ru);
+	check_address ((uint8_t *) (ru + 1) - 1);
+	if (process_getrusage (who, &usage) < 0)
+		return -1;
+	*ru = usage;
+	return 0;
+}
+
+/* 호출한 스레드의 scheduling class를 POLICY로 바꿉니다.
+	SCHED_FIFO는 budget으로 제한되므로 유저 프로세스도 요청할 수 있지만,
+	커널 스레드보다 앞서지 않도록 RT_PRIORITY는 SCHED_RT_PRIO_USER_MAX까지만 허용합니다.
+	성공하면 0, 인자가 잘못되었으면 -1을 반환합니다. */
+int
+sys_sched_setscheduler (int policy, int rt_priority) {
+	if (policy == SCHED_FIFO && rt_priority > SCHED_RT_PRIO_USER_MAX)
+		return -1;
+	return thread_set_scheduler (policy, rt_priority);
+}
+
+/* UADDR의 값이 아직 EXPECTED이면 futex_wake가 불릴 때까지 잠듭니다.
+	깨워졌으면 0, 값이 달랐거나 주소가 잘못되었으면 -1을 반환합니다. */
+int
+sys_futex_wait (const int *uaddr, int expected) {
+	return futex_wait (uaddr, expected);
+}
+
+/* UADDR에서 잠든 스레드를 최대 N개 깨우고 깨운 개수를 반환합니다. */
+int
+sys_futex_wake (const int *uaddr, int n) {
+	return futex_wake (uaddr, n);
+}
+
+tid_t
+sys_thread_create (void *entry, void *function, void *aux) {
+	if (entry == NULL || is_kernel_vaddr (entry))
+		sys_exit (-1);
+	return process_thread_create (entry, function, aux);
+}
+
+int
+sys_thread_join (tid_t tid) {
+	return process_thread_join (tid);
+}
+
+void
+sys_thread_exit (int status) {
+	process_thread_exit (status);
+}
@@ -2,8 +2,8 @@
 #include <debug.h>
 #include <stddef.h>
 #include "userprog/gdt.h"
+#include "threads/cpu.h"
 #include "threads/thread.h"
-#include "threads/palloc.h"
 #include "threads/vaddr.h"
 #include "intrinsic.h"
 
@@ -43,24 +43,30 @@
  *      not in use, so we can always use that.  Thus, when the
  *      scheduler switches threads, it also changes the TSS's
  *      stack pointer to point to the new thread's kernel stack.
- *      (The call is in schedule in thread.c.) */
+ *      (The call is in schedule in thread.c.)
+ *
+ *  Each CPU switches threads on its own, so each CPU has its own
+ *  TSS, kept in its `struct cpu'. */
 
-/* Kernel TSS. */
-struct task_state *tss;
+/* The TSS of each CPU.  Static, because application processors
+ * set theirs up before they may allocate memory. */
+static struct task_state tss_table[NCPU_MAX];
 
-/* Initializes the kernel TSS. */
+/* Initializes the kernel TSS of the current CPU. */
 void
 tss_init (void) {
 	/* Our TSS is never used in a call gate or task gate, so only a
 	 * few fields of it are ever referenced, and those are the only
 	 * ones we initialize. */
-	tss = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+	this_cpu ()->tss = &tss_table[this_cpu ()->id];
 	tss_update (thread_current ());
 }
 
-/* Returns the kernel TSS. */
+/* Returns the kernel TSS of the current CPU. */
 struct task_state *
 tss_get (void) {
+	struct task_state *tss = this_cpu ()->tss;
+
 	ASSERT (tss != NULL);
 	return tss;
 }
@@ -69,6 +75,5 @@ tss_get (void) {
  * of the thread stack. */
 void
 tss_update (struct thread *next) {
-	ASSERT (tss != NULL);
-	tss->rsp0 = (uint64_t) next + PGSIZE;
+	tss_get ()->rsp0 = (uint64_t) next + PGSIZE;
 }